@@ -1,8 +1,30 @@
 #include <iostream>
 #include <vector>
 #include <queue>
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <future>
+#include <thread>
+#include <iterator>
+#include <cstddef>
+#include <chrono>
+#include <random>
+#include <atomic>
+#include <mutex>
+#include <cstdint>
+#include <memory>
 #include <fstream>
 #include <sstream>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__unix__) || defined(__APPLE__)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 // AVL Tree
 
 struct Node {
@@ -10,22 +32,248 @@ struct Node {
 	Node* right;
 	int key;
 	int height;
+	size_t size;
 
-	Node(int value) : left(nullptr), right(nullptr), key(value), height(0) {}
+	Node(int value) : left(nullptr), right(nullptr), key(value), height(0), size(1) {}
+};
+
+// Binary snapshot of sorted keys: header, varint-encoded deltas, then an index of every blockSize-th key.
+// Integers are stored in host byte order.
+
+struct SnapshotHeader {
+	char magic[4];
+	uint32_t blockSize;
+	uint64_t count;
+	uint64_t indexOffset;
+};
+
+struct SnapshotIndexEntry {
+	int32_t firstKey;
+	uint32_t padding;
+	uint64_t offset;
+};
+
+const char SNAPSHOT_MAGIC[4] = { 'A', 'V', 'L', 'S' };
+const uint32_t SNAPSHOT_BLOCK = 64;
+
+void writeVarint(std::ostream& out, uint32_t value) {
+	char bytes[5];
+	int length = 0;
+	while (value >= 0x80) {
+		bytes[length++] = (char)(value | 0x80);
+		value >>= 7;
+	}
+	bytes[length++] = (char)value;
+	out.write(bytes, length);
+}
+
+uint32_t readVarint(const unsigned char*& p, const unsigned char* end) {
+	uint32_t value = 0;
+	for (int shift = 0; shift < 35; shift += 7) {
+		if (p >= end) {
+			throw std::runtime_error("Truncated snapshot data");
+		}
+		unsigned char byte = *p++;
+		value |= (uint32_t)(byte & 0x7F) << shift;
+		if ((byte & 0x80) == 0) return value;
+	}
+	throw std::runtime_error("Malformed varint in snapshot");
+}
+
+// Read-only view of a snapshot file, memory-mapped where the platform allows it
+class SnapshotFile {
+private:
+	const unsigned char* base;
+	size_t length;
+	std::vector<unsigned char> buffer;
+	const SnapshotHeader* header;
+	const SnapshotIndexEntry* index;
+	size_t blockCount;
+
+	void close() {
+#if defined(__unix__) || defined(__APPLE__)
+		if (base != nullptr and buffer.empty()) {
+			munmap(const_cast<unsigned char*>(base), length);
+		}
+#endif
+		base = nullptr;
+		length = 0;
+		buffer.clear();
+		header = nullptr;
+		index = nullptr;
+		blockCount = 0;
+	}
+
+	bool mapFile(const std::string& filename) {
+#if defined(__unix__) || defined(__APPLE__)
+		int fd = ::open(filename.c_str(), O_RDONLY);
+		if (fd < 0) return false;
+		struct stat st;
+		if (fstat(fd, &st) != 0 or st.st_size == 0) {
+			::close(fd);
+			return false;
+		}
+		void* mapped = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+		::close(fd);
+		if (mapped == MAP_FAILED) return false;
+		base = static_cast<const unsigned char*>(mapped);
+		length = st.st_size;
+		return true;
+#else
+		std::ifstream file(filename, std::ios::binary);
+		if (!file.is_open()) return false;
+		buffer.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+		base = buffer.data();
+		length = buffer.size();
+		return true;
+#endif
+	}
+
+	// Block offsets must point into the data section in order and first keys must increase.
+	// A block holding a single key reads no varints, so its offset may equal indexOffset.
+	bool validIndex() const {
+		uint64_t previousOffset = sizeof(SnapshotHeader);
+		for (size_t b = 0; b < blockCount; b++) {
+			uint64_t inBlock = std::min<uint64_t>(header->blockSize, header->count - b * header->blockSize);
+			uint64_t offset = index[b].offset;
+			if (offset < previousOffset or offset > header->indexOffset or (inBlock > 1 and offset == header->indexOffset)) {
+				return false;
+			}
+			if (b > 0 and index[b].firstKey <= index[b - 1].firstKey) {
+				return false;
+			}
+			previousOffset = offset;
+		}
+		return true;
+	}
+
+public:
+	// Yields the keys in ascending order, throws std::runtime_error on corrupted data
+	class Cursor {
+	public:
+		explicit Cursor(const SnapshotFile& file) : file(file), position(0), p(nullptr), key(0) {}
+
+		int next() {
+			size_t block = position / file.header->blockSize;
+			if (position % file.header->blockSize == 0) {
+				int previous = key;
+				key = file.index[block].firstKey;
+				p = file.base + file.index[block].offset;
+				if (position > 0 and key <= previous) {
+					throw std::runtime_error("Snapshot keys out of order");
+				}
+			}
+			else {
+				int previous = key;
+				key = (int32_t)((uint32_t)key + readVarint(p, file.base + file.header->indexOffset));
+				if (key <= previous) {
+					throw std::runtime_error("Snapshot keys out of order");
+				}
+			}
+			position++;
+			return key;
+		}
+
+	private:
+		const SnapshotFile& file;
+		size_t position;
+		const unsigned char* p;
+		int key;
+	};
+
+	SnapshotFile() : base(nullptr), length(0), header(nullptr), index(nullptr), blockCount(0) {}
+	~SnapshotFile() {
+		close();
+	}
+
+	SnapshotFile(const SnapshotFile&) = delete;
+	SnapshotFile& operator=(const SnapshotFile&) = delete;
+
+	bool open(const std::string& filename) {
+		close();
+		if (not mapFile(filename)) {
+			std::cerr << "Unable to open file: " << filename << std::endl;
+			return false;
+		}
+		header = reinterpret_cast<const SnapshotHeader*>(base);
+		if (length < sizeof(SnapshotHeader) or not std::equal(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4, header->magic) or header->blockSize == 0) {
+			std::cerr << "Not a snapshot file: " << filename << std::endl;
+			close();
+			return false;
+		}
+		blockCount = header->count / header->blockSize + (header->count % header->blockSize != 0);
+		// every key after the first of its block takes at least one byte of the data section
+		if (header->indexOffset < sizeof(SnapshotHeader) or header->indexOffset % alignof(SnapshotIndexEntry) != 0 or header->indexOffset > length
+			or header->count - blockCount > header->indexOffset - sizeof(SnapshotHeader)
+			or (length - header->indexOffset) / sizeof(SnapshotIndexEntry) != blockCount) {
+			std::cerr << "Corrupted snapshot file: " << filename << std::endl;
+			close();
+			return false;
+		}
+		index = reinterpret_cast<const SnapshotIndexEntry*>(base + header->indexOffset);
+		if (not validIndex()) {
+			std::cerr << "Corrupted snapshot file: " << filename << std::endl;
+			close();
+			return false;
+		}
+		return true;
+	}
+
+	size_t size() const {
+		return header ? header->count : 0;
+	}
+
+	bool containsKey(const int key) const {
+		if (blockCount == 0) return false;
+		size_t lo = 0;
+		size_t hi = blockCount;
+		while (hi - lo > 1) {
+			size_t mid = lo + (hi - lo) / 2;
+			if (index[mid].firstKey <= key) lo = mid;
+			else hi = mid;
+		}
+		int current = index[lo].firstKey;
+		if (current >= key) return current == key;
+		const unsigned char* p = base + index[lo].offset;
+		const unsigned char* end = base + header->indexOffset;
+		size_t inBlock = std::min<uint64_t>(header->blockSize, header->count - lo * header->blockSize);
+		for (size_t i = 1; i < inBlock; i++) {
+			current = (int32_t)((uint32_t)current + readVarint(p, end));
+			if (current >= key) return current == key;
+		}
+		return false;
+	}
+
+	void inOrderPrint() const {
+		Cursor cursor(*this);
+		for (size_t i = 0; i < size(); i++) {
+			std::cout << cursor.next() << " ";
+		}
+		std::cout << "\n";
+	}
 };
 
 class BinaryTree {
 private:
 	Node* root;
 
+	// AVL height stays below 1.45 * log2(n + 2), so this covers any tree that fits in memory
+	static const int MAX_DEPTH = 96;
+
 	int height(Node* node) {
 		if (node == nullptr) return -1;
 		return node->height;
 	}
 	
+	size_t size(const Node* node) const {
+		if (node == nullptr) return 0;
+		return node->size;
+	}
+
 	void updateHeight(Node* node) {
 		if (node == nullptr) return;
 		node->height = 1 + std::max(height(node->left), height(node->right));
+		node->size = 1 + size(node->left) + size(node->right);
 	}
 
 	int balanceFactor(Node* node) {
@@ -143,13 +391,215 @@ private:
 		}
 	}
 
-	void inOrderPrint(const Node* node) const {
+	Node* build(const std::vector<int>& keys, size_t lo, size_t hi) {
+		if (lo >= hi) return nullptr;
+		size_t mid = lo + (hi - lo) / 2;
+		Node* node = new Node(keys[mid]);
+		node->left = build(keys, lo, mid);
+		node->right = build(keys, mid + 1, hi);
+		updateHeight(node);
+		return node;
+	}
+
+	Node* build(SnapshotFile::Cursor& cursor, size_t count) {
+		if (count == 0) return nullptr;
+		size_t leftCount = count / 2;
+		Node* left = build(cursor, leftCount);
+		Node* node = new Node(cursor.next());
+		node->left = left;
+		node->right = build(cursor, count - leftCount - 1);
+		updateHeight(node);
+		return node;
+	}
+
+	Node* link(const std::vector<Node*>& nodes, size_t lo, size_t hi) {
+		if (lo >= hi) return nullptr;
+		size_t mid = lo + (hi - lo) / 2;
+		Node* node = nodes[mid];
+		node->left = link(nodes, lo, mid);
+		node->right = link(nodes, mid + 1, hi);
+		updateHeight(node);
+		return node;
+	}
+
+	void flatten(Node* node, std::vector<Node*>& out) {
 		if (node == nullptr) return;
-		inOrderPrint(node->left);
-		std::cout << node->key << " ";
-		inOrderPrint(node->right);
+		flatten(node->left, out);
+		out.push_back(node);
+		flatten(node->right, out);
 	}
-	
+
+	// Number of keys less than key, or less or equal when inclusive
+	size_t rank(const Node* node, const int key, bool inclusive) const {
+		size_t res = 0;
+		while (node != nullptr) {
+			if (key < node->key or (key == node->key and not inclusive)) {
+				node = node->left;
+			}
+			else {
+				res += size(node->left) + 1;
+				if (key == node->key) break;
+				node = node->right;
+			}
+		}
+		return res;
+	}
+
+	struct SplitResult {
+		Node* left;
+		Node* middle;
+		Node* right;
+	};
+
+	static const int PARALLEL_MIN_HEIGHT = 12;
+
+	Node* joinRight(Node* l, Node* k, Node* r) {
+		if (height(l) <= height(r) + 1) {
+			k->left = l;
+			k->right = r;
+			updateHeight(k);
+			return k;
+		}
+		l->right = joinRight(l->right, k, r);
+		return balance(l);
+	}
+
+	Node* joinLeft(Node* l, Node* k, Node* r) {
+		if (height(r) <= height(l) + 1) {
+			k->left = l;
+			k->right = r;
+			updateHeight(k);
+			return k;
+		}
+		r->left = joinLeft(l, k, r->left);
+		return balance(r);
+	}
+
+	// All keys in l < k->key < all keys in r
+	Node* join(Node* l, Node* k, Node* r) {
+		if (height(l) > height(r) + 1) {
+			return joinRight(l, k, r);
+		}
+		if (height(r) > height(l) + 1) {
+			return joinLeft(l, k, r);
+		}
+		k->left = l;
+		k->right = r;
+		updateHeight(k);
+		return k;
+	}
+
+	Node* splitLast(Node* node, Node*& last) {
+		if (node->right == nullptr) {
+			last = node;
+			return node->left;
+		}
+		Node* rest = splitLast(node->right, last);
+		return join(node->left, node, rest);
+	}
+
+	Node* join2(Node* l, Node* r) {
+		if (l == nullptr) return r;
+		Node* last = nullptr;
+		Node* rest = splitLast(l, last);
+		return join(rest, last, r);
+	}
+
+	SplitResult split(Node* node, const int key) {
+		if (node == nullptr) {
+			return { nullptr, nullptr, nullptr };
+		}
+		Node* l = node->left;
+		Node* r = node->right;
+		if (key < node->key) {
+			SplitResult s = split(l, key);
+			return { s.left, s.middle, join(s.right, node, r) };
+		}
+		if (key > node->key) {
+			SplitResult s = split(r, key);
+			return { join(l, node, s.left), s.middle, s.right };
+		}
+		node->left = nullptr;
+		node->right = nullptr;
+		node->height = 0;
+		node->size = 1;
+		return { l, node, r };
+	}
+
+	// Runs both halves, the left one as a separate task while the depth budget and subtree height allow it
+	template <typename LeftTask, typename RightTask>
+	void forkJoin(int depth, Node* node, Node*& l, Node*& r, LeftTask left, RightTask right) {
+		if (depth > 0 and height(node) >= PARALLEL_MIN_HEIGHT) {
+			auto future = std::async(std::launch::async, left);
+			r = right();
+			l = future.get();
+		}
+		else {
+			l = left();
+			r = right();
+		}
+	}
+
+	Node* unionNodes(Node* a, Node* b, int depth) {
+		if (a == nullptr) return b;
+		if (b == nullptr) return a;
+		SplitResult s = split(b, a->key);
+		delete s.middle;
+		Node* al = a->left;
+		Node* ar = a->right;
+		Node* l;
+		Node* r;
+		auto left = [&]() { return unionNodes(al, s.left, depth - 1); };
+		auto right = [&]() { return unionNodes(ar, s.right, depth - 1); };
+		forkJoin(depth, a, l, r, left, right);
+		return join(l, a, r);
+	}
+
+	Node* intersectNodes(Node* a, Node* b, int depth) {
+		if (a == nullptr or b == nullptr) {
+			clear(a);
+			clear(b);
+			return nullptr;
+		}
+		SplitResult s = split(b, a->key);
+		Node* al = a->left;
+		Node* ar = a->right;
+		Node* l;
+		Node* r;
+		auto left = [&]() { return intersectNodes(al, s.left, depth - 1); };
+		auto right = [&]() { return intersectNodes(ar, s.right, depth - 1); };
+		forkJoin(depth, a, l, r, left, right);
+		if (s.middle != nullptr) {
+			delete s.middle;
+			return join(l, a, r);
+		}
+		delete a;
+		return join2(l, r);
+	}
+
+	Node* differenceNodes(Node* a, Node* b, int depth) {
+		if (a == nullptr or b == nullptr) {
+			clear(b);
+			return a;
+		}
+		SplitResult s = split(a, b->key);
+		delete s.middle;
+		Node* bl = b->left;
+		Node* br = b->right;
+		Node* l;
+		Node* r;
+		auto left = [&]() { return differenceNodes(s.left, bl, depth - 1); };
+		auto right = [&]() { return differenceNodes(s.right, br, depth - 1); };
+		forkJoin(depth, b, l, r, left, right);
+		delete b;
+		return join2(l, r);
+	}
+
+	static int parallelDepth() {
+		unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+		return (int)std::ceil(std::log2(threads)) + 2;
+	}
+
 	void preOrderPrint(const Node* node) const {
 		if (node == nullptr) return;
 		std::cout << node->key << " ";
@@ -165,6 +615,110 @@ private:
 	}
 
 public:
+	// In-order iterator keeping the root-to-node path in a fixed array, no recursion or allocation
+	class const_iterator {
+	public:
+		using iterator_category = std::bidirectional_iterator_tag;
+		using value_type = int;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const int*;
+		using reference = const int&;
+
+		const_iterator() : root(nullptr), depth(0) {}
+
+		reference operator*() const {
+			return path[depth - 1]->key;
+		}
+
+		pointer operator->() const {
+			return &path[depth - 1]->key;
+		}
+
+		const_iterator& operator++() {
+			const Node* node = path[depth - 1];
+			if (node->right != nullptr) {
+				pushLeftmost(node->right);
+				return *this;
+			}
+			const Node* child;
+			do {
+				child = path[--depth];
+			} while (depth > 0 and path[depth - 1]->right == child);
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator old = *this;
+			++(*this);
+			return old;
+		}
+
+		const_iterator& operator--() {
+			if (depth == 0) {
+				pushRightmost(root);
+				return *this;
+			}
+			const Node* node = path[depth - 1];
+			if (node->left != nullptr) {
+				pushRightmost(node->left);
+				return *this;
+			}
+			const Node* child;
+			do {
+				child = path[--depth];
+			} while (depth > 0 and path[depth - 1]->left == child);
+			return *this;
+		}
+
+		const_iterator operator--(int) {
+			const_iterator old = *this;
+			--(*this);
+			return old;
+		}
+
+		bool operator==(const const_iterator& other) const {
+			if (depth == 0 or other.depth == 0) {
+				return depth == other.depth;
+			}
+			return path[depth - 1] == other.path[other.depth - 1];
+		}
+
+		bool operator!=(const const_iterator& other) const {
+			return not (*this == other);
+		}
+
+	private:
+		friend class BinaryTree;
+
+		const Node* root;
+		const Node* path[MAX_DEPTH];
+		int depth;
+
+		explicit const_iterator(const Node* root) : root(root), depth(0) {}
+
+		void pushLeftmost(const Node* node) {
+			while (node != nullptr) {
+				path[depth++] = node;
+				node = node->left;
+			}
+		}
+
+		void pushRightmost(const Node* node) {
+			while (node != nullptr) {
+				path[depth++] = node;
+				node = node->right;
+			}
+		}
+	};
+
+	struct Range {
+		const_iterator first;
+		const_iterator last;
+
+		const_iterator begin() const { return first; }
+		const_iterator end() const { return last; }
+	};
+
 	BinaryTree() : root(nullptr) {}
 	~BinaryTree() {
 		clear(root);
@@ -182,10 +736,225 @@ public:
 		root = erase(root, key);
 	}
 
+	// Replaces the tree with a perfectly balanced one in O(n), keys must be sorted
+	void buildFrom(const std::vector<int>& sortedKeys) {
+		if (not std::is_sorted(sortedKeys.begin(), sortedKeys.end())) {
+			throw std::invalid_argument("buildFrom expects sorted keys");
+		}
+		clear(root);
+		root = nullptr;
+		if (std::adjacent_find(sortedKeys.begin(), sortedKeys.end()) == sortedKeys.end()) {
+			root = build(sortedKeys, 0, sortedKeys.size());
+			return;
+		}
+		std::vector<int> uniqueKeys;
+		uniqueKeys.reserve(sortedKeys.size());
+		std::unique_copy(sortedKeys.begin(), sortedKeys.end(), std::back_inserter(uniqueKeys));
+		root = build(uniqueKeys, 0, uniqueKeys.size());
+	}
+
+	// Removes all given keys, for large batches merges them with the in-order sequence and relinks surviving nodes in O(n + m)
+	void eraseAll(const std::vector<int>& sortedKeys) {
+		if (not std::is_sorted(sortedKeys.begin(), sortedKeys.end())) {
+			throw std::invalid_argument("eraseAll expects sorted keys");
+		}
+		if (root == nullptr or sortedKeys.empty()) return;
+
+		size_t n = size(root);
+		if (sortedKeys.size() * std::log2(n + 1) < n) {
+			for (const int key : sortedKeys) {
+				root = erase(root, key);
+			}
+			return;
+		}
+
+		std::vector<Node*> nodes;
+		nodes.reserve(n);
+		flatten(root, nodes);
+
+		size_t kept = 0;
+		auto it = sortedKeys.begin();
+		for (Node* node : nodes) {
+			while (it != sortedKeys.end() and *it < node->key) {
+				++it;
+			}
+			if (it != sortedKeys.end() and *it == node->key) {
+				delete node;
+			}
+			else {
+				nodes[kept++] = node;
+			}
+		}
+		root = link(nodes, 0, kept);
+	}
+
+	// Set operations move all nodes of other into this tree, other is left empty
+	void unionWith(BinaryTree& other) {
+		if (&other == this) return;
+		root = unionNodes(root, other.root, parallelDepth());
+		other.root = nullptr;
+	}
+
+	void intersectWith(BinaryTree& other) {
+		if (&other == this) return;
+		root = intersectNodes(root, other.root, parallelDepth());
+		other.root = nullptr;
+	}
+
+	void differenceWith(BinaryTree& other) {
+		if (&other == this) {
+			clear(root);
+			root = nullptr;
+			return;
+		}
+		root = differenceNodes(root, other.root, parallelDepth());
+		other.root = nullptr;
+	}
+
+	size_t size() const {
+		return size(root);
+	}
+
+	// Number of keys less than key
+	size_t rank(const int key) const {
+		return rank(root, key, false);
+	}
+
+	// k-th smallest key, counted from 0
+	int select(size_t k) const {
+		if (k >= size(root)) {
+			throw std::out_of_range("Selecting key outside of tree");
+		}
+		const Node* node = root;
+		while (true) {
+			size_t leftSize = size(node->left);
+			if (k < leftSize) {
+				node = node->left;
+			}
+			else if (k == leftSize) {
+				return node->key;
+			}
+			else {
+				k -= leftSize + 1;
+				node = node->right;
+			}
+		}
+	}
+
+	// Number of keys in [lo, hi]
+	size_t countRange(const int lo, const int hi) const {
+		if (hi < lo) return 0;
+		return rank(root, hi, true) - rank(root, lo, false);
+	}
+
+	const_iterator begin() const {
+		const_iterator it(root);
+		it.pushLeftmost(root);
+		return it;
+	}
+
+	const_iterator end() const {
+		return const_iterator(root);
+	}
+
+	// First key not less than key, or greater than key when strict
+	const_iterator lowerBound(const int key, bool strict = false) const {
+		const_iterator it(root);
+		int found = 0;
+		const Node* node = root;
+		while (node != nullptr) {
+			it.path[it.depth++] = node;
+			if (key < node->key or (key == node->key and not strict)) {
+				found = it.depth;
+				node = node->left;
+			}
+			else {
+				node = node->right;
+			}
+		}
+		it.depth = found;
+		return it;
+	}
+
+	const_iterator upperBound(const int key) const {
+		return lowerBound(key, true);
+	}
+
+	// Keys in [lo, hi] in ascending order
+	Range range(const int lo, const int hi) const {
+		if (hi < lo) {
+			return { end(), end() };
+		}
+		return { lowerBound(lo), upperBound(hi) };
+	}
+
 	void inOrderPrint() const {
-		inOrderPrint(root);
+		for (const int key : *this) {
+			std::cout << key << " ";
+		}
 		std::cout << "\n";
 	}
+
+	bool save(const std::string& filename) const {
+		std::ofstream file(filename, std::ios::binary);
+		if (!file.is_open()) {
+			std::cerr << "Unable to open file: " << filename << std::endl;
+			return false;
+		}
+		SnapshotHeader header;
+		std::copy(SNAPSHOT_MAGIC, SNAPSHOT_MAGIC + 4, header.magic);
+		header.blockSize = SNAPSHOT_BLOCK;
+		header.count = size();
+		header.indexOffset = 0;
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+		std::vector<SnapshotIndexEntry> index;
+		index.reserve(header.count / SNAPSHOT_BLOCK + 1);
+		size_t position = 0;
+		int previous = 0;
+		for (const int key : *this) {
+			if (position % SNAPSHOT_BLOCK == 0) {
+				index.push_back({ key, 0, (uint64_t)file.tellp() });
+			}
+			else {
+				writeVarint(file, (uint32_t)key - (uint32_t)previous);
+			}
+			previous = key;
+			position++;
+		}
+		while (file.tellp() % alignof(SnapshotIndexEntry) != 0) {
+			file.put(0);
+		}
+		header.indexOffset = file.tellp();
+		file.write(reinterpret_cast<const char*>(index.data()), index.size() * sizeof(SnapshotIndexEntry));
+		file.seekp(0);
+		file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		return file.good();
+	}
+
+	// Rebuilds a perfectly balanced tree straight from the sorted stream, no rotations
+	bool load(const std::string& filename) {
+		SnapshotFile file;
+		if (not file.open(filename)) {
+			return false;
+		}
+		// validate the whole stream first so a corrupted file leaves the tree untouched
+		try {
+			SnapshotFile::Cursor check(file);
+			for (size_t i = 0; i < file.size(); i++) {
+				check.next();
+			}
+		}
+		catch (const std::runtime_error& e) {
+			std::cerr << "Corrupted snapshot file: " << filename << " (" << e.what() << ")" << std::endl;
+			return false;
+		}
+		clear(root);
+		root = nullptr;
+		SnapshotFile::Cursor cursor(file);
+		root = build(cursor, file.size());
+		return true;
+	}
 	
 	void preOrderPrint() const {
 		preOrderPrint(root);
@@ -234,6 +1003,933 @@ public:
 	}
 };
 
+// B+ tree, nodes are whole cache lines and in-node search is done with SSE2 compares
+
+class BPlusTree {
+private:
+	static const int LEAF_CAPACITY = 60;
+	static const int INNER_CAPACITY = 40;
+	static const int LEAF_MIN = LEAF_CAPACITY / 2;
+	static const int INNER_MIN = INNER_CAPACITY / 2;
+
+	struct alignas(64) Leaf {
+		int keys[LEAF_CAPACITY];
+		int count;
+		Leaf* next;
+
+		Leaf() : count(0), next(nullptr) {}
+	};
+
+	// children[i] holds keys in [keys[i - 1], keys[i])
+	struct alignas(64) Inner {
+		int keys[INNER_CAPACITY];
+		int count;
+		void* children[INNER_CAPACITY + 1];
+
+		Inner() : count(0) {}
+	};
+
+	static_assert(sizeof(Leaf) % 64 == 0, "Leaf must fill whole cache lines");
+	static_assert(sizeof(Inner) % 64 == 0, "Inner must fill whole cache lines");
+
+	void* root;
+	int levels; // 0 means root is a leaf
+	size_t keyCount;
+	size_t leafCount;
+	size_t innerCount;
+
+	// Number of keys less than key, or less or equal when inclusive
+	static int countLess(const int* keys, int count, const int key, bool inclusive) {
+		int i = 0;
+#ifdef __SSE2__
+		const __m128i needle = _mm_set1_epi32(key);
+		for (; i + 4 <= count; i += 4) {
+			__m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(keys + i));
+			int mask;
+			if (inclusive) {
+				mask = _mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(block, needle)));
+			}
+			else {
+				mask = ~_mm_movemask_ps(_mm_castsi128_ps(_mm_cmpgt_epi32(needle, block))) & 0xF;
+			}
+			if (mask != 0) {
+				return i + __builtin_ctz(mask);
+			}
+		}
+#endif
+		while (i < count and (keys[i] < key or (inclusive and keys[i] == key))) {
+			i++;
+		}
+		return i;
+	}
+
+	Leaf* findLeaf(const int key) const {
+		void* node = root;
+		for (int level = levels; level > 0; level--) {
+			const Inner* inner = static_cast<const Inner*>(node);
+			node = inner->children[countLess(inner->keys, inner->count, key, true)];
+		}
+		return static_cast<Leaf*>(node);
+	}
+
+	// Returns true when the key was added, a split hands back the separator and new right node
+	bool insert(void* node, int level, const int key, int& splitKey, void*& splitNode) {
+		splitNode = nullptr;
+		if (level == 0) {
+			Leaf* leaf = static_cast<Leaf*>(node);
+			int pos = countLess(leaf->keys, leaf->count, key, false);
+			if (pos < leaf->count and leaf->keys[pos] == key) {
+				return false;
+			}
+			if (leaf->count < LEAF_CAPACITY) {
+				std::copy_backward(leaf->keys + pos, leaf->keys + leaf->count, leaf->keys + leaf->count + 1);
+				leaf->keys[pos] = key;
+				leaf->count++;
+				return true;
+			}
+			Leaf* right = new Leaf();
+			leafCount++;
+			int half = LEAF_CAPACITY / 2;
+			std::copy(leaf->keys + half, leaf->keys + LEAF_CAPACITY, right->keys);
+			right->count = LEAF_CAPACITY - half;
+			leaf->count = half;
+			right->next = leaf->next;
+			leaf->next = right;
+			Leaf* target = pos <= half ? leaf : right;
+			if (target == right) pos -= half;
+			std::copy_backward(target->keys + pos, target->keys + target->count, target->keys + target->count + 1);
+			target->keys[pos] = key;
+			target->count++;
+			splitKey = right->keys[0];
+			splitNode = right;
+			return true;
+		}
+
+		Inner* inner = static_cast<Inner*>(node);
+		int i = countLess(inner->keys, inner->count, key, true);
+		int childKey;
+		void* childNode;
+		if (not insert(inner->children[i], level - 1, key, childKey, childNode)) {
+			return false;
+		}
+		if (childNode == nullptr) {
+			return true;
+		}
+		if (inner->count < INNER_CAPACITY) {
+			std::copy_backward(inner->keys + i, inner->keys + inner->count, inner->keys + inner->count + 1);
+			std::copy_backward(inner->children + i + 1, inner->children + inner->count + 1, inner->children + inner->count + 2);
+			inner->keys[i] = childKey;
+			inner->children[i + 1] = childNode;
+			inner->count++;
+			return true;
+		}
+
+		int keys[INNER_CAPACITY + 1];
+		void* children[INNER_CAPACITY + 2];
+		std::copy(inner->keys, inner->keys + i, keys);
+		keys[i] = childKey;
+		std::copy(inner->keys + i, inner->keys + INNER_CAPACITY, keys + i + 1);
+		std::copy(inner->children, inner->children + i + 1, children);
+		children[i + 1] = childNode;
+		std::copy(inner->children + i + 1, inner->children + INNER_CAPACITY + 1, children + i + 2);
+
+		Inner* right = new Inner();
+		innerCount++;
+		int mid = (INNER_CAPACITY + 1) / 2;
+		inner->count = mid;
+		std::copy(keys, keys + mid, inner->keys);
+		std::copy(children, children + mid + 1, inner->children);
+		right->count = INNER_CAPACITY - mid;
+		std::copy(keys + mid + 1, keys + INNER_CAPACITY + 1, right->keys);
+		std::copy(children + mid + 1, children + INNER_CAPACITY + 2, right->children);
+		splitKey = keys[mid];
+		splitNode = right;
+		return true;
+	}
+
+	void fixLeafChild(Inner* parent, int i) {
+		Leaf* child = static_cast<Leaf*>(parent->children[i]);
+		if (child->count >= LEAF_MIN) return;
+		Leaf* left = i > 0 ? static_cast<Leaf*>(parent->children[i - 1]) : nullptr;
+		Leaf* right = i < parent->count ? static_cast<Leaf*>(parent->children[i + 1]) : nullptr;
+
+		if (left != nullptr and left->count > LEAF_MIN) {
+			std::copy_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+			child->keys[0] = left->keys[--left->count];
+			child->count++;
+			parent->keys[i - 1] = child->keys[0];
+			return;
+		}
+		if (right != nullptr and right->count > LEAF_MIN) {
+			child->keys[child->count++] = right->keys[0];
+			std::copy(right->keys + 1, right->keys + right->count, right->keys);
+			right->count--;
+			parent->keys[i] = right->keys[0];
+			return;
+		}
+		if (left != nullptr) {
+			mergeLeaves(parent, i - 1);
+		}
+		else {
+			mergeLeaves(parent, i);
+		}
+	}
+
+	// Moves children[i + 1] into children[i] and drops the separator between them
+	void mergeLeaves(Inner* parent, int i) {
+		Leaf* left = static_cast<Leaf*>(parent->children[i]);
+		Leaf* right = static_cast<Leaf*>(parent->children[i + 1]);
+		std::copy(right->keys, right->keys + right->count, left->keys + left->count);
+		left->count += right->count;
+		left->next = right->next;
+		delete right;
+		leafCount--;
+		removeSeparator(parent, i);
+	}
+
+	void fixInnerChild(Inner* parent, int i) {
+		Inner* child = static_cast<Inner*>(parent->children[i]);
+		if (child->count >= INNER_MIN) return;
+		Inner* left = i > 0 ? static_cast<Inner*>(parent->children[i - 1]) : nullptr;
+		Inner* right = i < parent->count ? static_cast<Inner*>(parent->children[i + 1]) : nullptr;
+
+		if (left != nullptr and left->count > INNER_MIN) {
+			std::copy_backward(child->keys, child->keys + child->count, child->keys + child->count + 1);
+			std::copy_backward(child->children, child->children + child->count + 1, child->children + child->count + 2);
+			child->keys[0] = parent->keys[i - 1];
+			child->children[0] = left->children[left->count];
+			child->count++;
+			parent->keys[i - 1] = left->keys[--left->count];
+			return;
+		}
+		if (right != nullptr and right->count > INNER_MIN) {
+			child->keys[child->count] = parent->keys[i];
+			child->children[child->count + 1] = right->children[0];
+			child->count++;
+			parent->keys[i] = right->keys[0];
+			std::copy(right->keys + 1, right->keys + right->count, right->keys);
+			std::copy(right->children + 1, right->children + right->count + 1, right->children);
+			right->count--;
+			return;
+		}
+		if (left != nullptr) {
+			mergeInner(parent, i - 1);
+		}
+		else {
+			mergeInner(parent, i);
+		}
+	}
+
+	void mergeInner(Inner* parent, int i) {
+		Inner* left = static_cast<Inner*>(parent->children[i]);
+		Inner* right = static_cast<Inner*>(parent->children[i + 1]);
+		left->keys[left->count] = parent->keys[i];
+		std::copy(right->keys, right->keys + right->count, left->keys + left->count + 1);
+		std::copy(right->children, right->children + right->count + 1, left->children + left->count + 1);
+		left->count += right->count + 1;
+		delete right;
+		innerCount--;
+		removeSeparator(parent, i);
+	}
+
+	void removeSeparator(Inner* parent, int i) {
+		std::copy(parent->keys + i + 1, parent->keys + parent->count, parent->keys + i);
+		std::copy(parent->children + i + 2, parent->children + parent->count + 1, parent->children + i + 1);
+		parent->count--;
+	}
+
+	bool erase(void* node, int level, const int key) {
+		if (level == 0) {
+			Leaf* leaf = static_cast<Leaf*>(node);
+			int pos = countLess(leaf->keys, leaf->count, key, false);
+			if (pos == leaf->count or leaf->keys[pos] != key) {
+				return false;
+			}
+			std::copy(leaf->keys + pos + 1, leaf->keys + leaf->count, leaf->keys + pos);
+			leaf->count--;
+			return true;
+		}
+		Inner* inner = static_cast<Inner*>(node);
+		int i = countLess(inner->keys, inner->count, key, true);
+		if (not erase(inner->children[i], level - 1, key)) {
+			return false;
+		}
+		if (level == 1) {
+			fixLeafChild(inner, i);
+		}
+		else {
+			fixInnerChild(inner, i);
+		}
+		return true;
+	}
+
+	void clear(void* node, int level) {
+		if (node == nullptr) return;
+		if (level == 0) {
+			delete static_cast<Leaf*>(node);
+			return;
+		}
+		Inner* inner = static_cast<Inner*>(node);
+		for (int i = 0; i <= inner->count; i++) {
+			clear(inner->children[i], level - 1);
+		}
+		delete inner;
+	}
+
+public:
+	class const_iterator {
+	public:
+		using iterator_category = std::forward_iterator_tag;
+		using value_type = int;
+		using difference_type = std::ptrdiff_t;
+		using pointer = const int*;
+		using reference = const int&;
+
+		const_iterator() : leaf(nullptr), index(0) {}
+
+		reference operator*() const {
+			return leaf->keys[index];
+		}
+
+		pointer operator->() const {
+			return &leaf->keys[index];
+		}
+
+		const_iterator& operator++() {
+			if (++index == leaf->count) {
+				leaf = leaf->next;
+				index = 0;
+			}
+			return *this;
+		}
+
+		const_iterator operator++(int) {
+			const_iterator old = *this;
+			++(*this);
+			return old;
+		}
+
+		bool operator==(const const_iterator& other) const {
+			return leaf == other.leaf and index == other.index;
+		}
+
+		bool operator!=(const const_iterator& other) const {
+			return not (*this == other);
+		}
+
+	private:
+		friend class BPlusTree;
+
+		const Leaf* leaf;
+		int index;
+
+		const_iterator(const Leaf* leaf, int index) : leaf(leaf), index(index) {}
+	};
+
+	BPlusTree() : root(nullptr), levels(0), keyCount(0), leafCount(0), innerCount(0) {}
+	~BPlusTree() {
+		clear(root, levels);
+	}
+
+	BPlusTree(const BPlusTree&) = delete;
+	BPlusTree& operator=(const BPlusTree&) = delete;
+
+	void insert(const int key) {
+		if (root == nullptr) {
+			root = new Leaf();
+			leafCount++;
+		}
+		int splitKey;
+		void* splitNode;
+		if (not insert(root, levels, key, splitKey, splitNode)) {
+			return;
+		}
+		keyCount++;
+		if (splitNode != nullptr) {
+			Inner* newRoot = new Inner();
+			innerCount++;
+			newRoot->keys[0] = splitKey;
+			newRoot->children[0] = root;
+			newRoot->children[1] = splitNode;
+			newRoot->count = 1;
+			root = newRoot;
+			levels++;
+		}
+	}
+
+	bool containsKey(const int key) const {
+		if (root == nullptr) return false;
+		const Leaf* leaf = findLeaf(key);
+		int pos = countLess(leaf->keys, leaf->count, key, false);
+		return pos < leaf->count and leaf->keys[pos] == key;
+	}
+
+	void erase(const int key) {
+		if (root == nullptr or not erase(root, levels, key)) {
+			return;
+		}
+		keyCount--;
+		if (levels > 0 and static_cast<Inner*>(root)->count == 0) {
+			Inner* oldRoot = static_cast<Inner*>(root);
+			root = oldRoot->children[0];
+			delete oldRoot;
+			innerCount--;
+			levels--;
+		}
+		else if (levels == 0 and static_cast<Leaf*>(root)->count == 0) {
+			delete static_cast<Leaf*>(root);
+			leafCount--;
+			root = nullptr;
+		}
+	}
+
+	size_t size() const {
+		return keyCount;
+	}
+
+	size_t memoryUsage() const {
+		return leafCount * sizeof(Leaf) + innerCount * sizeof(Inner);
+	}
+
+	const_iterator begin() const {
+		if (root == nullptr) return end();
+		void* node = root;
+		for (int level = levels; level > 0; level--) {
+			node = static_cast<Inner*>(node)->children[0];
+		}
+		return const_iterator(static_cast<Leaf*>(node), 0);
+	}
+
+	const_iterator end() const {
+		return const_iterator();
+	}
+
+	void inOrderPrint() const {
+		for (const int key : *this) {
+			std::cout << key << " ";
+		}
+		std::cout << "\n";
+	}
+};
+
+// Concurrent AVL tree, readers never lock and validate node versions (Bronson et al. optimistic hand-over-hand)
+
+struct ConcurrentNode {
+	const int key;
+	std::atomic<bool> present;
+	std::atomic<ConcurrentNode*> left;
+	std::atomic<ConcurrentNode*> right;
+	// Odd while the node is being rotated down, changes after every such rotation
+	std::atomic<uint64_t> version;
+	ConcurrentNode* parent;
+	int height;
+
+	ConcurrentNode(int value, ConcurrentNode* parent) : key(value), present(true), left(nullptr), right(nullptr), version(0), parent(parent), height(0) {}
+
+	std::atomic<ConcurrentNode*>& child(bool goLeft) {
+		return goLeft ? left : right;
+	}
+};
+
+class ConcurrentBinaryTree {
+private:
+	static const uint64_t UNLINKED = ~uint64_t(0);
+	static const int READER_SLOTS = 64;
+	static const size_t RECLAIM_BATCH = 1024;
+
+	struct alignas(64) ReaderSlot {
+		std::atomic<int> active[2];
+	};
+
+	// Holder never moves, the real root is its right child
+	ConcurrentNode holder;
+	std::mutex writerLock;
+	std::atomic<uint64_t> epoch;
+	ReaderSlot readers[READER_SLOTS];
+	std::vector<ConcurrentNode*> retired;
+
+	enum Lookup { NOT_FOUND, FOUND, RETRY };
+
+	static ReaderSlot& slotFor(ReaderSlot* readers) {
+		static std::atomic<int> nextSlot(0);
+		thread_local int slot = nextSlot.fetch_add(1) % READER_SLOTS;
+		return readers[slot];
+	}
+
+	// Keeps unlinked nodes alive while a reader that might still see them is running
+	class ReadGuard {
+	public:
+		explicit ReadGuard(ConcurrentBinaryTree& tree) : slot(slotFor(tree.readers)) {
+			while (true) {
+				e = tree.epoch.load() & 1;
+				slot.active[e].fetch_add(1);
+				if ((tree.epoch.load() & 1) == e) break;
+				slot.active[e].fetch_sub(1);
+			}
+		}
+		~ReadGuard() {
+			slot.active[e].fetch_sub(1);
+		}
+
+	private:
+		ReaderSlot& slot;
+		uint64_t e;
+	};
+
+	Lookup attemptContains(const int key) {
+		ConcurrentNode* node = &holder;
+		uint64_t nodeV = node->version.load();
+		bool goLeft = false;
+		while (true) {
+			ConcurrentNode* child = node->child(goLeft).load();
+			if (node->version.load() != nodeV) return RETRY;
+			if (child == nullptr) return NOT_FOUND;
+			if (key == child->key) {
+				return child->present.load() ? FOUND : NOT_FOUND;
+			}
+			uint64_t childV = child->version.load();
+			if (childV == UNLINKED) return RETRY;
+			if (childV & 1) {
+				while (child->version.load() == childV) {
+					std::this_thread::yield();
+				}
+				continue;
+			}
+			if (child != node->child(goLeft).load() or node->version.load() != nodeV) return RETRY;
+			node = child;
+			nodeV = childV;
+			goLeft = key < child->key;
+		}
+	}
+
+	static int height(const ConcurrentNode* node) {
+		if (node == nullptr) return -1;
+		return node->height;
+	}
+
+	static void updateHeight(ConcurrentNode* node) {
+		node->height = 1 + std::max(height(node->left.load()), height(node->right.load()));
+	}
+
+	static int balanceFactor(const ConcurrentNode* node) {
+		return height(node->left.load()) - height(node->right.load());
+	}
+
+	void replaceChild(ConcurrentNode* parent, ConcurrentNode* oldChild, ConcurrentNode* newChild) {
+		if (parent->left.load() == oldChild) {
+			parent->left.store(newChild);
+		}
+		else {
+			parent->right.store(newChild);
+		}
+		if (newChild != nullptr) {
+			newChild->parent = parent;
+		}
+	}
+
+	// Moves node down to the right, readers inside node see the version change and retry
+	ConcurrentNode* rotateRight(ConcurrentNode* node) {
+		ConcurrentNode* parent = node->parent;
+		ConcurrentNode* c = node->left.load();
+		ConcurrentNode* t2 = c->right.load();
+		uint64_t v = node->version.load();
+		node->version.store(v + 1);
+
+		node->left.store(t2);
+		if (t2 != nullptr) t2->parent = node;
+		c->right.store(node);
+		node->parent = c;
+		replaceChild(parent, node, c);
+
+		node->version.store(v + 2);
+		updateHeight(node);
+		updateHeight(c);
+		return c;
+	}
+
+	ConcurrentNode* rotateLeft(ConcurrentNode* node) {
+		ConcurrentNode* parent = node->parent;
+		ConcurrentNode* c = node->right.load();
+		ConcurrentNode* t2 = c->left.load();
+		uint64_t v = node->version.load();
+		node->version.store(v + 1);
+
+		node->right.store(t2);
+		if (t2 != nullptr) t2->parent = node;
+		c->left.store(node);
+		node->parent = c;
+		replaceChild(parent, node, c);
+
+		node->version.store(v + 2);
+		updateHeight(node);
+		updateHeight(c);
+		return c;
+	}
+
+	void unlink(ConcurrentNode* node) {
+		ConcurrentNode* child = node->left.load() ? node->left.load() : node->right.load();
+		replaceChild(node->parent, node, child);
+		node->version.store(UNLINKED);
+		retired.push_back(node);
+	}
+
+	// Walks from node to the root, drops routing nodes with at most one child and restores AVL balance
+	void fixUp(ConcurrentNode* node) {
+		while (node != &holder) {
+			ConcurrentNode* parent = node->parent;
+			if (not node->present.load() and (node->left.load() == nullptr or node->right.load() == nullptr)) {
+				unlink(node);
+				node = parent;
+				continue;
+			}
+			updateHeight(node);
+			int bf = balanceFactor(node);
+			if (bf > 1) {
+				if (balanceFactor(node->left.load()) < 0) {
+					rotateLeft(node->left.load());
+				}
+				rotateRight(node);
+			}
+			else if (bf < -1) {
+				if (balanceFactor(node->right.load()) > 0) {
+					rotateRight(node->right.load());
+				}
+				rotateLeft(node);
+			}
+			node = parent;
+		}
+	}
+
+	// Frees retired nodes once every reader that started before they were unlinked has finished
+	void reclaim() {
+		uint64_t old = epoch.fetch_add(1) & 1;
+		for (ReaderSlot& slot : readers) {
+			while (slot.active[old].load() != 0) {
+				std::this_thread::yield();
+			}
+		}
+		for (ConcurrentNode* node : retired) {
+			delete node;
+		}
+		retired.clear();
+	}
+
+	void clear(ConcurrentNode* node) {
+		if (node == nullptr) return;
+		clear(node->left.load());
+		clear(node->right.load());
+		delete node;
+	}
+
+	void inOrderPrint(const ConcurrentNode* node) const {
+		if (node == nullptr) return;
+		inOrderPrint(node->left.load());
+		if (node->present.load()) {
+			std::cout << node->key << " ";
+		}
+		inOrderPrint(node->right.load());
+	}
+
+public:
+	ConcurrentBinaryTree() : holder(0, nullptr), epoch(0) {
+		for (ReaderSlot& slot : readers) {
+			slot.active[0].store(0);
+			slot.active[1].store(0);
+		}
+	}
+	~ConcurrentBinaryTree() {
+		clear(holder.right.load());
+		for (ConcurrentNode* node : retired) {
+			delete node;
+		}
+	}
+
+	// Safe to call from any number of threads concurrently with writers
+	bool containsKey(const int key) {
+		ReadGuard guard(*this);
+		while (true) {
+			Lookup res = attemptContains(key);
+			if (res != RETRY) return res == FOUND;
+		}
+	}
+
+	void insert(const int key) {
+		std::lock_guard<std::mutex> lock(writerLock);
+		ConcurrentNode* parent = &holder;
+		bool goLeft = false;
+		ConcurrentNode* node = holder.right.load();
+		while (node != nullptr) {
+			if (key == node->key) {
+				node->present.store(true);
+				return;
+			}
+			parent = node;
+			goLeft = key < node->key;
+			node = node->child(goLeft).load();
+		}
+		parent->child(goLeft).store(new ConcurrentNode(key, parent));
+		fixUp(parent);
+	}
+
+	void erase(const int key) {
+		std::lock_guard<std::mutex> lock(writerLock);
+		ConcurrentNode* node = holder.right.load();
+		while (node != nullptr and key != node->key) {
+			node = node->child(key < node->key).load();
+		}
+		if (node == nullptr or not node->present.load()) return;
+		node->present.store(false);
+		fixUp(node);
+		if (retired.size() >= RECLAIM_BATCH) {
+			reclaim();
+		}
+	}
+
+	void inOrderPrint() {
+		std::lock_guard<std::mutex> lock(writerLock);
+		inOrderPrint(holder.right.load());
+		std::cout << "\n";
+	}
+};
+
+// Persistent AVL tree, updates copy the O(log n) nodes on the search path and share the rest
+
+struct PersistentNode;
+using PersistentPtr = std::shared_ptr<const PersistentNode>;
+
+struct PersistentNode {
+	PersistentPtr left;
+	PersistentPtr right;
+	int key;
+	int height;
+	size_t size;
+
+	PersistentNode(int value, PersistentPtr l, PersistentPtr r) : left(std::move(l)), right(std::move(r)), key(value) {
+		int lh = left ? left->height : -1;
+		int rh = right ? right->height : -1;
+		height = 1 + std::max(lh, rh);
+		size = 1 + (left ? left->size : 0) + (right ? right->size : 0);
+	}
+};
+
+class PersistentBinaryTree {
+private:
+	PersistentPtr root;
+
+	static int height(const PersistentPtr& node) {
+		if (node == nullptr) return -1;
+		return node->height;
+	}
+
+	static PersistentPtr make(int key, PersistentPtr l, PersistentPtr r) {
+		return std::make_shared<const PersistentNode>(key, std::move(l), std::move(r));
+	}
+
+	// Builds node (key, l, r) and restores AVL balance with copied rotations
+	static PersistentPtr balance(int key, PersistentPtr l, PersistentPtr r) {
+		int bf = height(l) - height(r);
+		if (bf > 1) {
+			if (height(l->left) < height(l->right)) {
+				const PersistentPtr& lr = l->right;
+				return make(lr->key, make(l->key, l->left, lr->left), make(key, lr->right, std::move(r)));
+			}
+			return make(l->key, l->left, make(key, l->right, std::move(r)));
+		}
+		if (bf < -1) {
+			if (height(r->right) < height(r->left)) {
+				const PersistentPtr& rl = r->left;
+				return make(rl->key, make(key, std::move(l), rl->left), make(r->key, rl->right, r->right));
+			}
+			return make(r->key, make(key, std::move(l), r->left), r->right);
+		}
+		return make(key, std::move(l), std::move(r));
+	}
+
+	static PersistentPtr insert(const PersistentPtr& node, const int key) {
+		if (node == nullptr) {
+			return make(key, nullptr, nullptr);
+		}
+		if (key < node->key) {
+			PersistentPtr l = insert(node->left, key);
+			if (l == node->left) return node;
+			return balance(node->key, std::move(l), node->right);
+		}
+		if (key > node->key) {
+			PersistentPtr r = insert(node->right, key);
+			if (r == node->right) return node;
+			return balance(node->key, node->left, std::move(r));
+		}
+		return node;
+	}
+
+	static PersistentPtr eraseMin(const PersistentPtr& node, int& minKey) {
+		if (node->left == nullptr) {
+			minKey = node->key;
+			return node->right;
+		}
+		return balance(node->key, eraseMin(node->left, minKey), node->right);
+	}
+
+	static PersistentPtr erase(const PersistentPtr& node, const int key) {
+		if (node == nullptr) {
+			return node;
+		}
+		if (key < node->key) {
+			PersistentPtr l = erase(node->left, key);
+			if (l == node->left) return node;
+			return balance(node->key, std::move(l), node->right);
+		}
+		if (key > node->key) {
+			PersistentPtr r = erase(node->right, key);
+			if (r == node->right) return node;
+			return balance(node->key, node->left, std::move(r));
+		}
+		if (node->left == nullptr) return node->right;
+		if (node->right == nullptr) return node->left;
+		int successor;
+		PersistentPtr r = eraseMin(node->right, successor);
+		return balance(successor, node->left, std::move(r));
+	}
+
+	static void inOrderPrint(const PersistentPtr& node) {
+		if (node == nullptr) return;
+		inOrderPrint(node->left);
+		std::cout << node->key << " ";
+		inOrderPrint(node->right);
+	}
+
+public:
+	PersistentBinaryTree() : root(nullptr) {}
+
+	void insert(const int key) {
+		root = insert(root, key);
+	}
+
+	void erase(const int key) {
+		root = erase(root, key);
+	}
+
+	bool containsKey(const int key) const {
+		const PersistentNode* node = root.get();
+		while (node != nullptr) {
+			if (key < node->key) node = node->left.get();
+			else if (key > node->key) node = node->right.get();
+			else return true;
+		}
+		return false;
+	}
+
+	size_t size() const {
+		return root ? root->size : 0;
+	}
+
+	// O(1) point-in-time copy, nodes are freed when the last version using them goes away
+	PersistentBinaryTree snapshot() const {
+		return *this;
+	}
+
+	void inOrderPrint() const {
+		inOrderPrint(root);
+		std::cout << "\n";
+	}
+};
+
+void benchmarkOrderedSets(size_t n) {
+	std::mt19937 rng(42);
+	std::vector<int> keys(n);
+	for (auto& key : keys) {
+		key = (int)rng();
+	}
+	std::vector<int> queries(n);
+	for (size_t i = 0; i < n; i++) {
+		queries[i] = (i % 2 == 0) ? keys[rng() % n] : (int)rng();
+	}
+
+	auto elapsedMs = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	BinaryTree avl;
+	auto start = std::chrono::steady_clock::now();
+	for (const int key : keys) avl.insert(key);
+	double avlInsert = elapsedMs(start);
+	size_t avlHits = 0;
+	start = std::chrono::steady_clock::now();
+	for (const int key : queries) avlHits += avl.containsKey(key);
+	double avlLookup = elapsedMs(start);
+
+	BPlusTree btree;
+	start = std::chrono::steady_clock::now();
+	for (const int key : keys) btree.insert(key);
+	double btreeInsert = elapsedMs(start);
+	size_t btreeHits = 0;
+	start = std::chrono::steady_clock::now();
+	for (const int key : queries) btreeHits += btree.containsKey(key);
+	double btreeLookup = elapsedMs(start);
+
+	std::cout << "keys: " << n << ", hits: " << avlHits << " / " << btreeHits << "\n";
+	std::cout << "AVL   insert " << avlInsert << " ms, lookup " << avlLookup << " ms, memory " << avl.size() * sizeof(Node) / (1 << 20) << " MiB\n";
+	std::cout << "B+    insert " << btreeInsert << " ms, lookup " << btreeLookup << " ms, memory " << btree.memoryUsage() / (1 << 20) << " MiB\n";
+}
+
+
+// Readers check every answer against writes that finished before and started after it, the mix is 95 % reads
+void stressTestConcurrentTree(int threadCount, int keyRange, int opsPerThread) {
+	ConcurrentBinaryTree tree;
+	std::vector<std::atomic<uint32_t>> changes(keyRange);
+	std::vector<std::atomic<bool>> expected(keyRange);
+	std::vector<std::mutex> keyLocks(keyRange);
+	for (int k = 0; k < keyRange; k++) {
+		changes[k].store(0);
+		expected[k].store(false);
+	}
+	std::atomic<long long> errors(0);
+	std::atomic<long long> reads(0);
+
+	auto worker = [&](int id) {
+		std::mt19937 rng(id);
+		for (int i = 0; i < opsPerThread; i++) {
+			int key = rng() % keyRange;
+			if (rng() % 100 < 5) {
+				std::lock_guard<std::mutex> lock(keyLocks[key]);
+				bool add = rng() % 2;
+				changes[key].fetch_add(1);
+				if (add) tree.insert(key);
+				else tree.erase(key);
+				expected[key].store(add);
+				changes[key].fetch_add(1);
+			}
+			else {
+				uint32_t before = changes[key].load();
+				bool want = expected[key].load();
+				bool got = tree.containsKey(key);
+				if (before % 2 == 0 and changes[key].load() == before and got != want) {
+					errors.fetch_add(1);
+				}
+				reads.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	std::vector<std::thread> threads;
+	for (int t = 0; t < threadCount; t++) {
+		threads.emplace_back(worker, t);
+	}
+	for (auto& thread : threads) {
+		thread.join();
+	}
+	double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+	for (int k = 0; k < keyRange; k++) {
+		if (tree.containsKey(k) != expected[k].load()) {
+			errors.fetch_add(1);
+		}
+	}
+	std::cout << "threads: " << threadCount << ", reads/s: " << reads.load() / seconds << ", errors: " << errors.load() << "\n";
+}
+
+
 std::vector<int> readIntegersFromFile(const std::string& filename) {
     std::ifstream file(filename);
     std::vector<int> numbersVec;
@@ -259,6 +1955,8 @@ std::vector<int> readIntegersFromFile(const std::string& filename) {
 }
 
 int main(int argc, char* argv[]) {
+	//benchmarkOrderedSets(10000000);
+	//stressTestConcurrentTree(32, 100000, 1000000);
     if( argc != 3 ){
     std::cerr << "Not enough arguments\n";
     return 1;
@@ -1,8 +1,49 @@
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <functional>
+#include <iterator>
+#include <cstdint>
+#include <stdexcept>
 
 using std::vector;
 
+template <size_t D, typename RandomIt, typename Compare>
+void siftDown(RandomIt first, size_t index, const size_t size, Compare& compare) {
+	auto value = std::move(first[index]);
+	while (D * index + 1 < size) {
+		size_t child = D * index + 1;
+		size_t last = std::min(child + D, size);
+		size_t best = child;
+		for (++child; child < last; child++) {
+			if (compare(first[best], first[child])) {
+				best = child;
+			}
+		}
+		if (not compare(value, first[best])) break;
+		first[index] = std::move(first[best]);
+		index = best;
+	}
+	first[index] = std::move(value);
+}
+
+// In-place d-ary heap sort with O(1) extra memory, ascending under compare.
+// With k set, stops after k extractions: the k largest end up sorted in [last - k, last).
+template <size_t D = 2, typename RandomIt, typename Compare = std::less<typename std::iterator_traits<RandomIt>::value_type>>
+void heapSort(RandomIt first, RandomIt last, Compare compare = Compare(), size_t k = SIZE_MAX) {
+	static_assert(D >= 2, "Heap arity must be at least 2");
+	size_t size = last - first;
+	if (size < 2) return;
+	for (size_t i = (size - 2) / D + 1; i-- > 0;) {
+		siftDown<D>(first, i, size, compare);
+	}
+	for (size_t extracted = 0; extracted < k and size > 1; extracted++) {
+		size--;
+		std::swap(first[0], first[size]);
+		siftDown<D>(first, 0, size, compare);
+	}
+}
+
 class myHeap {
 private:
 	vector<int> data;
@@ -90,13 +131,8 @@ public:
 	}
 
 	static vector<int> heapSort(vector<int>& data) {
-		myHeap heap(data);
-		vector<int> res;
-
-		while (not heap.empty()) {
-			res.push_back(heap.getMax());
-		}
-
+		vector<int> res = data;
+		::heapSort(res.begin(), res.end(), std::greater<int>());
 		return res;
 	}
 
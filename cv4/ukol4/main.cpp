@@ -2,6 +2,19 @@
 #include <vector>
 #include <fstream>
 #include <sstream>
+#include <algorithm>
+#include <functional>
+#include <stdexcept>
+#include <chrono>
+#include <random>
+#include <new>
+#include <type_traits>
+#include <cstdint>
+#include <utility>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
 
 using std::vector;
 
@@ -10,31 +23,32 @@ private:
 	vector<int> data;
 	size_t n;
 
-	vector<size_t> children(const size_t index) {
-		vector<size_t> children_index;
-		for(size_t i = 1; i <= n; ++i){
-		    children_index.push_back(n * index + i);
-		}
-		return children_index;
-	}
-	
 	size_t parentIndex(const size_t index) {
 		return (index - 1) / n;
 	}
 
-	void heapify(const size_t index) {
-		vector<size_t> c = children(index);
-		size_t largest = index;
+	void heapify(size_t index) {
+		while (true) {
+			size_t largest = index;
+			size_t end = std::min(n * index + n + 1, data.size());
 
-		for (const auto child : c) {
-			if (not (child < data.size())) { break; }
-			if (data[child] > data[largest]) {
-				largest = child;
+			for (size_t child = n * index + 1; child < end; child++) {
+				if (data[child] > data[largest]) {
+					largest = child;
+				}
 			}
-		}
-		if (largest != index) {
+			if (largest == index) { break; }
 			std::swap(data[index], data[largest]);
-			heapify(largest);
+			index = largest;
+		}
+	}
+
+	void siftUp(size_t currentIndex) {
+		while (currentIndex != 0) {
+			size_t parent = parentIndex(currentIndex);
+			if (not (data[currentIndex] > data[parent])) { break; }
+			std::swap(data[currentIndex], data[parent]);
+			currentIndex = parent;
 		}
 	}
 
@@ -55,17 +69,7 @@ public:
 
 	void insert(const int key) {
 		data.push_back(key);
-		if (data.size() == 1) {
-			return;
-		}
-		size_t currentIndex = data.size() - 1;
-		size_t parent = parentIndex(currentIndex);
-
-		while (currentIndex != 0 and data[currentIndex] > data[parent]) {
-			std::swap(data[currentIndex], data[parent]);
-			currentIndex = parent;
-			parent = parentIndex(currentIndex);
-		}
+		siftUp(data.size() - 1);
 	}
 
 	int getMax() {
@@ -96,8 +100,884 @@ public:
 	bool empty() const {
 		return data.empty();
 	}
+
+	size_t size() const {
+		return data.size();
+	}
+
+	// Small batches are sifted up one by one, larger ones are appended and only the subtrees
+	// above the new elements are heapified bottom-up, level by level
+	template <typename InputIt>
+	void insertBatch(InputIt first, InputIt last) {
+		size_t oldSize = data.size();
+		data.insert(data.end(), first, last);
+		size_t batch = data.size() - oldSize;
+		if (batch == 0) return;
+
+		size_t depth = 0;
+		for (size_t levelEnd = 1; levelEnd < data.size(); levelEnd = levelEnd * n + 1) {
+			depth++;
+		}
+		if (batch <= depth) {
+			for (size_t i = oldSize; i < data.size(); i++) {
+				siftUp(i);
+			}
+			return;
+		}
+		if (oldSize <= batch) {
+			makeHeap();
+			return;
+		}
+
+		size_t lo = oldSize;
+		size_t hi = data.size() - 1;
+		while (lo != 0) {
+			lo = parentIndex(lo);
+			hi = parentIndex(hi);
+			for (size_t i = hi + 1; i-- > lo;) {
+				heapify(i);
+			}
+		}
+	}
+
+	void insertBatch(const vector<int>& keys) {
+		insertBatch(keys.begin(), keys.end());
+	}
+
+	// Moves all elements of other into this heap, other is left empty
+	void merge(myHeap& other) {
+		if (&other == this) return;
+		insertBatch(other.data.begin(), other.data.end());
+		other.data.clear();
+	}
+};
+
+const size_t CACHE_LINE = 64;
+
+template <typename T>
+struct CacheAlignedAllocator {
+	using value_type = T;
+
+	CacheAlignedAllocator() = default;
+	template <typename U>
+	CacheAlignedAllocator(const CacheAlignedAllocator<U>&) {}
+
+	T* allocate(size_t count) {
+		return static_cast<T*>(::operator new(count * sizeof(T), std::align_val_t(CACHE_LINE)));
+	}
+
+	void deallocate(T* p, size_t) {
+		::operator delete(p, std::align_val_t(CACHE_LINE));
+	}
+
+	template <typename U>
+	bool operator==(const CacheAlignedAllocator<U>&) const { return true; }
+	template <typename U>
+	bool operator!=(const CacheAlignedAllocator<U>&) const { return false; }
+};
+
+// d-ary heap with the arity fixed at compile time, top is the largest element under Compare.
+// Storage starts on a cache line and is shifted by D - 1 slots when D small elements fit a line,
+// so the D children of every node share one line.
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class DaryHeap {
+	static_assert(D >= 2, "Heap arity must be at least 2");
+
+private:
+	static constexpr bool ALIGN_CHILDREN = std::is_trivially_copyable<T>::value and D * sizeof(T) <= CACHE_LINE and CACHE_LINE % (D * sizeof(T)) == 0;
+	static constexpr size_t OFFSET = ALIGN_CHILDREN ? D - 1 : 0;
+
+	vector<T, CacheAlignedAllocator<T>> data;
+	Compare compare;
+
+	static constexpr size_t firstChild(const size_t index) {
+		return D * index + 1;
+	}
+
+	static constexpr size_t parentIndex(const size_t index) {
+		return (index - 1) / D;
+	}
+
+	T& at(const size_t index) {
+		return data[index + OFFSET];
+	}
+
+	size_t bestChild(size_t first, const size_t size) {
+		size_t last = std::min(first + D, size);
+		size_t best = first;
+		for (size_t child = first + 1; child < last; child++) {
+			if (compare(at(best), at(child))) {
+				best = child;
+			}
+		}
+		return best;
+	}
+
+	void siftUp(size_t index, T value) {
+		while (index != 0) {
+			size_t parent = parentIndex(index);
+			if (not compare(at(parent), value)) break;
+			at(index) = std::move(at(parent));
+			index = parent;
+		}
+		at(index) = std::move(value);
+	}
+
+	void siftDown(size_t index) {
+		const size_t count = size();
+		T value = std::move(at(index));
+		while (firstChild(index) < count) {
+			size_t best = bestChild(firstChild(index), count);
+			if (not compare(value, at(best))) break;
+			at(index) = std::move(at(best));
+			index = best;
+		}
+		at(index) = std::move(value);
+	}
+
+	void makeHeap() {
+		if (size() < 2) return;
+		for (size_t i = parentIndex(size() - 1) + 1; i-- > 0;) {
+			siftDown(i);
+		}
+	}
+
+public:
+	// Reserves capacity up front, inserts stay allocation-free until it is exceeded
+	explicit DaryHeap(size_t capacity = 0, Compare compare = Compare()) : data(OFFSET), compare(compare) {
+		data.reserve(capacity + OFFSET);
+	}
+
+	DaryHeap(const vector<T>& input, Compare compare = Compare()) : data(OFFSET), compare(compare) {
+		data.reserve(input.size() + OFFSET);
+		data.insert(data.end(), input.begin(), input.end());
+		makeHeap();
+	}
+
+	void reserve(size_t capacity) {
+		data.reserve(capacity + OFFSET);
+	}
+
+	void insert(T key) {
+		data.push_back(std::move(key));
+		siftUp(size() - 1, std::move(data.back()));
+	}
+
+	const T& top() const {
+		if (empty()) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		return data[OFFSET];
+	}
+
+	// Bottom-up pop: the hole walks to a leaf along the larger children without comparing
+	// against the moved last element, which is then sifted up from there (usually 0-1 levels)
+	T getMax() {
+		if (empty()) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		T maximum = std::move(at(0));
+		T last = std::move(data.back());
+		data.pop_back();
+		const size_t count = size();
+		if (count == 0) {
+			return maximum;
+		}
+		size_t hole = 0;
+		while (firstChild(hole) < count) {
+			size_t best = bestChild(firstChild(hole), count);
+			at(hole) = std::move(at(best));
+			hole = best;
+		}
+		siftUp(hole, std::move(last));
+		return maximum;
+	}
+
+	size_t size() const {
+		return data.size() - OFFSET;
+	}
+
+	bool empty() const {
+		return size() == 0;
+	}
+
+	void print() const {
+		for (size_t i = OFFSET; i < data.size(); i++) {
+			std::cout << data[i] << " ";
+		}
+		std::cout << "\n";
+	}
 };
 
+// Keys are ordered by Compare with the largest on top. increaseKey moves an element towards the top,
+// decreaseKey away from it; for a min-heap built with std::greater, increaseKey is the classic decrease-key.
+
+// d-ary heap with stable handles, a position index maps each handle to its place in the array
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class AddressableHeap {
+	static_assert(D >= 2, "Heap arity must be at least 2");
+
+public:
+	using Handle = size_t;
+
+private:
+	static constexpr size_t FREE = SIZE_MAX;
+
+	struct Entry {
+		T key;
+		Handle handle;
+	};
+
+	vector<Entry> data;
+	vector<size_t> position;
+	vector<Handle> freeHandles;
+	Compare compare;
+
+	static constexpr size_t firstChild(const size_t index) {
+		return D * index + 1;
+	}
+
+	static constexpr size_t parentIndex(const size_t index) {
+		return (index - 1) / D;
+	}
+
+	void place(const size_t index, Entry entry) {
+		position[entry.handle] = index;
+		data[index] = std::move(entry);
+	}
+
+	void siftUp(size_t index) {
+		Entry entry = std::move(data[index]);
+		while (index != 0) {
+			size_t parent = parentIndex(index);
+			if (not compare(data[parent].key, entry.key)) break;
+			place(index, std::move(data[parent]));
+			index = parent;
+		}
+		place(index, std::move(entry));
+	}
+
+	void siftDown(size_t index) {
+		const size_t count = data.size();
+		Entry entry = std::move(data[index]);
+		while (firstChild(index) < count) {
+			size_t first = firstChild(index);
+			size_t last = std::min(first + D, count);
+			size_t best = first;
+			for (size_t child = first + 1; child < last; child++) {
+				if (compare(data[best].key, data[child].key)) {
+					best = child;
+				}
+			}
+			if (not compare(entry.key, data[best].key)) break;
+			place(index, std::move(data[best]));
+			index = best;
+		}
+		place(index, std::move(entry));
+	}
+
+	size_t indexOf(const Handle handle) const {
+		if (handle >= position.size() or position[handle] == FREE) {
+			throw std::out_of_range("Invalid heap handle");
+		}
+		return position[handle];
+	}
+
+	// Moves the last entry into index and restores the heap around it
+	void removeAt(const size_t index) {
+		position[data[index].handle] = FREE;
+		freeHandles.push_back(data[index].handle);
+		Entry last = std::move(data.back());
+		data.pop_back();
+		if (index == data.size()) return;
+		place(index, std::move(last));
+		if (index != 0 and compare(data[parentIndex(index)].key, data[index].key)) {
+			siftUp(index);
+		}
+		else {
+			siftDown(index);
+		}
+	}
+
+public:
+	explicit AddressableHeap(size_t capacity = 0, Compare compare = Compare()) : compare(compare) {
+		data.reserve(capacity);
+		position.reserve(capacity);
+	}
+
+	Handle insert(T key) {
+		Handle handle;
+		if (freeHandles.empty()) {
+			handle = position.size();
+			position.push_back(FREE);
+		}
+		else {
+			handle = freeHandles.back();
+			freeHandles.pop_back();
+		}
+		data.push_back({ std::move(key), handle });
+		siftUp(data.size() - 1);
+		return handle;
+	}
+
+	const T& top() const {
+		if (data.empty()) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		return data[0].key;
+	}
+
+	Handle topHandle() const {
+		if (data.empty()) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		return data[0].handle;
+	}
+
+	T getMax() {
+		if (data.empty()) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		T maximum = std::move(data[0].key);
+		removeAt(0);
+		return maximum;
+	}
+
+	const T& key(const Handle handle) const {
+		return data[indexOf(handle)].key;
+	}
+
+	bool contains(const Handle handle) const {
+		return handle < position.size() and position[handle] != FREE;
+	}
+
+	void increaseKey(const Handle handle, T key) {
+		size_t index = indexOf(handle);
+		if (compare(key, data[index].key)) {
+			throw std::invalid_argument("increaseKey would move the key down");
+		}
+		data[index].key = std::move(key);
+		siftUp(index);
+	}
+
+	void decreaseKey(const Handle handle, T key) {
+		size_t index = indexOf(handle);
+		if (compare(data[index].key, key)) {
+			throw std::invalid_argument("decreaseKey would move the key up");
+		}
+		data[index].key = std::move(key);
+		siftDown(index);
+	}
+
+	void erase(const Handle handle) {
+		removeAt(indexOf(handle));
+	}
+
+	size_t size() const {
+		return data.size();
+	}
+
+	bool empty() const {
+		return data.empty();
+	}
+};
+
+// Pairing heap, increaseKey is amortized O(1), getMax, decreaseKey and erase amortized O(log n)
+template <typename T, typename Compare = std::less<T>>
+class PairingHeap {
+private:
+	struct Node {
+		T key;
+		Node* child;
+		Node* next;
+		Node* prev; // parent for a first child, left sibling otherwise
+
+		explicit Node(T key) : key(std::move(key)), child(nullptr), next(nullptr), prev(nullptr) {}
+	};
+
+	Node* root;
+	size_t count;
+	vector<Node*> pairs;
+	Compare compare;
+
+	Node* meld(Node* a, Node* b) {
+		if (a == nullptr) return b;
+		if (b == nullptr) return a;
+		if (compare(a->key, b->key)) {
+			std::swap(a, b);
+		}
+		b->prev = a;
+		b->next = a->child;
+		if (a->child != nullptr) {
+			a->child->prev = b;
+		}
+		a->child = b;
+		a->next = nullptr;
+		a->prev = nullptr;
+		return a;
+	}
+
+	void cut(Node* node) {
+		if (node->prev->child == node) {
+			node->prev->child = node->next;
+		}
+		else {
+			node->prev->next = node->next;
+		}
+		if (node->next != nullptr) {
+			node->next->prev = node->prev;
+		}
+		node->next = nullptr;
+		node->prev = nullptr;
+	}
+
+	// Two-pass merge of a sibling list: pair left to right, then meld the pairs right to left
+	Node* mergeSiblings(Node* first) {
+		pairs.clear();
+		while (first != nullptr) {
+			Node* a = first;
+			Node* b = a->next;
+			first = b ? b->next : nullptr;
+			a->next = a->prev = nullptr;
+			if (b != nullptr) {
+				b->next = b->prev = nullptr;
+			}
+			pairs.push_back(meld(a, b));
+		}
+		Node* res = nullptr;
+		for (size_t i = pairs.size(); i-- > 0;) {
+			res = meld(pairs[i], res);
+		}
+		return res;
+	}
+
+	void clear() {
+		if (root == nullptr) return;
+		vector<Node*> stack = { root };
+		while (not stack.empty()) {
+			Node* node = stack.back();
+			stack.pop_back();
+			if (node->child) stack.push_back(node->child);
+			if (node->next) stack.push_back(node->next);
+			delete node;
+		}
+		root = nullptr;
+	}
+
+public:
+	using Handle = Node*;
+
+	explicit PairingHeap(Compare compare = Compare()) : root(nullptr), count(0), compare(compare) {}
+	~PairingHeap() {
+		clear();
+	}
+
+	PairingHeap(const PairingHeap&) = delete;
+	PairingHeap& operator=(const PairingHeap&) = delete;
+
+	Handle insert(T key) {
+		Node* node = new Node(std::move(key));
+		root = meld(root, node);
+		count++;
+		return node;
+	}
+
+	const T& top() const {
+		if (root == nullptr) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		return root->key;
+	}
+
+	T getMax() {
+		if (root == nullptr) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		Node* old = root;
+		T maximum = std::move(old->key);
+		root = mergeSiblings(old->child);
+		delete old;
+		count--;
+		return maximum;
+	}
+
+	void increaseKey(Handle node, T key) {
+		if (compare(key, node->key)) {
+			throw std::invalid_argument("increaseKey would move the key down");
+		}
+		node->key = std::move(key);
+		if (node == root) return;
+		cut(node);
+		root = meld(root, node);
+	}
+
+	void decreaseKey(Handle node, T key) {
+		if (compare(node->key, key)) {
+			throw std::invalid_argument("decreaseKey would move the key up");
+		}
+		node->key = std::move(key);
+		Node* children = mergeSiblings(node->child);
+		node->child = nullptr;
+		if (node == root) {
+			root = meld(node, children);
+			return;
+		}
+		cut(node);
+		root = meld(meld(root, children), node);
+	}
+
+	void erase(Handle node) {
+		if (node == root) {
+			getMax();
+			return;
+		}
+		cut(node);
+		root = meld(root, mergeSiblings(node->child));
+		delete node;
+		count--;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return root == nullptr;
+	}
+};
+
+// Monotone min-priority queue for integer keys: every key inserted must be at least the last popped one.
+// Bucket i holds keys whose highest bit differing from the last popped key is bit i - 1,
+// so each element moves to a lower bucket at most 64 times.
+template <typename Value>
+class RadixHeap {
+private:
+	static const int BUCKETS = 65;
+
+	vector<std::pair<uint64_t, Value>> buckets[BUCKETS];
+	uint64_t last;
+	size_t count;
+
+	int bucketIndex(const uint64_t key) const {
+		if (key == last) return 0;
+		return 64 - __builtin_clzll(key ^ last);
+	}
+
+	// Moves the smallest key into bucket 0 by re-bucketing the first non-empty bucket
+	void refill() {
+		if (not buckets[0].empty()) return;
+		int i = 1;
+		while (buckets[i].empty()) {
+			i++;
+		}
+		uint64_t minimum = buckets[i][0].first;
+		for (const auto& item : buckets[i]) {
+			minimum = std::min(minimum, item.first);
+		}
+		last = minimum;
+		for (auto& item : buckets[i]) {
+			buckets[bucketIndex(item.first)].push_back(std::move(item));
+		}
+		buckets[i].clear();
+	}
+
+public:
+	RadixHeap() : last(0), count(0) {}
+
+	void insert(const uint64_t key, Value value) {
+		if (key < last) {
+			throw std::invalid_argument("Radix heap key is smaller than the last popped key");
+		}
+		buckets[bucketIndex(key)].emplace_back(key, std::move(value));
+		count++;
+	}
+
+	uint64_t topKey() {
+		if (count == 0) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		refill();
+		return last;
+	}
+
+	std::pair<uint64_t, Value> getMin() {
+		if (count == 0) {
+			throw std::out_of_range("Getting items from empty heap");
+		}
+		refill();
+		std::pair<uint64_t, Value> minimum = std::move(buckets[0].back());
+		buckets[0].pop_back();
+		count--;
+		return minimum;
+	}
+
+	size_t size() const {
+		return count;
+	}
+
+	bool empty() const {
+		return count == 0;
+	}
+};
+
+// Relaxed concurrent priority queue (MultiQueue): c * P heaps with one lock each. insert goes to a
+// random heap, getMax locks the better top of two random heaps, so popped elements are only
+// approximately the largest, see measureRankError.
+template <typename T, size_t D = 4, typename Compare = std::less<T>>
+class MultiQueue {
+	static_assert(std::is_trivially_copyable<T>::value, "Cached tops are read without locking");
+
+private:
+	struct alignas(64) Queue {
+		std::mutex lock;
+		DaryHeap<T, D, Compare> heap;
+		std::atomic<bool> hasTop;
+		std::atomic<T> top;
+
+		Queue() : hasTop(false), top(T()) {}
+	};
+
+	vector<std::unique_ptr<Queue>> queues;
+	Compare compare;
+
+	size_t randomQueue() {
+		thread_local std::minstd_rand rng((unsigned)std::hash<std::thread::id>()(std::this_thread::get_id()));
+		return rng() % queues.size();
+	}
+
+	static void publishTop(Queue& queue) {
+		if (queue.heap.empty()) {
+			queue.hasTop.store(false, std::memory_order_relaxed);
+		}
+		else {
+			queue.top.store(queue.heap.top(), std::memory_order_relaxed);
+			queue.hasTop.store(true, std::memory_order_relaxed);
+		}
+	}
+
+	// True when b's cached top is better than a's
+	bool better(Queue& a, Queue& b) {
+		if (not b.hasTop.load(std::memory_order_relaxed)) return false;
+		if (not a.hasTop.load(std::memory_order_relaxed)) return true;
+		return compare(a.top.load(std::memory_order_relaxed), b.top.load(std::memory_order_relaxed));
+	}
+
+public:
+	explicit MultiQueue(size_t threads, size_t queuesPerThread = 2, Compare compare = Compare()) : compare(compare) {
+		size_t count = std::max<size_t>(1, threads * queuesPerThread);
+		for (size_t i = 0; i < count; i++) {
+			queues.push_back(std::make_unique<Queue>());
+		}
+	}
+
+	void insert(const T key) {
+		while (true) {
+			Queue& queue = *queues[randomQueue()];
+			if (not queue.lock.try_lock()) continue;
+			queue.heap.insert(key);
+			publishTop(queue);
+			queue.lock.unlock();
+			return;
+		}
+	}
+
+	// Returns false once every queue was seen empty
+	bool getMax(T& result) {
+		while (true) {
+			Queue* a = queues[randomQueue()].get();
+			Queue* b = queues[randomQueue()].get();
+			if (better(*a, *b)) {
+				std::swap(a, b);
+			}
+			if (not a->hasTop.load(std::memory_order_relaxed)) {
+				if (empty()) return false;
+				continue;
+			}
+			if (not a->lock.try_lock()) continue;
+			if (a->heap.empty()) {
+				a->lock.unlock();
+				continue;
+			}
+			result = a->heap.getMax();
+			publishTop(*a);
+			a->lock.unlock();
+			return true;
+		}
+	}
+
+	bool empty() const {
+		for (const auto& queue : queues) {
+			if (queue->hasTop.load()) return false;
+		}
+		return true;
+	}
+
+	size_t queueCount() const {
+		return queues.size();
+	}
+};
+
+template <size_t D>
+double benchmarkDaryHeap(const vector<int>& keys) {
+	auto start = std::chrono::steady_clock::now();
+	DaryHeap<int, D> heap(keys.size());
+	for (const int key : keys) {
+		heap.insert(key);
+	}
+	long long checksum = 0;
+	while (not heap.empty()) {
+		checksum += heap.getMax();
+	}
+	double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	std::cout << "D = " << D << ": " << ms << " ms (checksum " << checksum << ")\n";
+	return ms;
+}
+
+void benchmarkHeaps(size_t count) {
+	std::mt19937 rng(42);
+	vector<int> keys(count);
+	for (auto& key : keys) {
+		key = (int)rng();
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	myHeap heap(vector<int>(), 2);
+	for (const int key : keys) {
+		heap.insert(key);
+	}
+	while (not heap.empty()) {
+		heap.getMax();
+	}
+	std::cout << "myHeap n = 2: " << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count() << " ms\n";
+
+	benchmarkDaryHeap<2>(keys);
+	benchmarkDaryHeap<4>(keys);
+	benchmarkDaryHeap<8>(keys);
+	benchmarkDaryHeap<16>(keys);
+}
+
+
+// Event-simulation style workload: pop the smallest key, push a few later events
+void benchmarkMonotoneQueues(size_t count) {
+	std::mt19937 rng(42);
+	vector<uint32_t> delays(count * 2);
+	for (auto& delay : delays) {
+		delay = rng() % 100000;
+	}
+	auto elapsedMs = [](std::chrono::steady_clock::time_point start) {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	};
+
+	auto start = std::chrono::steady_clock::now();
+	DaryHeap<uint64_t, 4, std::greater<uint64_t>> dary(count);
+	uint64_t daryChecksum = 0;
+	size_t next = 0;
+	dary.insert(0);
+	while (not dary.empty()) {
+		uint64_t key = dary.getMax();
+		daryChecksum += key;
+		for (int i = 0; i < 2 and next < delays.size(); i++) {
+			dary.insert(key + delays[next++]);
+		}
+	}
+	std::cout << "DaryHeap<4>: " << elapsedMs(start) << " ms (checksum " << daryChecksum << ")\n";
+
+	start = std::chrono::steady_clock::now();
+	RadixHeap<int> radix;
+	uint64_t radixChecksum = 0;
+	next = 0;
+	radix.insert(0, 0);
+	while (not radix.empty()) {
+		uint64_t key = radix.getMin().first;
+		radixChecksum += key;
+		for (int i = 0; i < 2 and next < delays.size(); i++) {
+			radix.insert(key + delays[next++], 0);
+		}
+	}
+	std::cout << "RadixHeap:   " << elapsedMs(start) << " ms (checksum " << radixChecksum << ")\n";
+}
+
+
+// Average and maximum number of larger elements still queued when an element was popped,
+// single-threaded over distinct random keys
+template <size_t D>
+std::pair<double, size_t> measureRankError(MultiQueue<int, D>& queue, size_t count) {
+	std::mt19937 rng(7);
+	vector<int> keys(count);
+	for (size_t i = 0; i < count; i++) {
+		keys[i] = (int)i;
+	}
+	std::shuffle(keys.begin(), keys.end(), rng);
+	for (const int key : keys) {
+		queue.insert(key);
+	}
+
+	// Fenwick tree over the keys still in the queue
+	vector<int> tree(count + 1, 0);
+	auto add = [&](size_t i, int delta) {
+		for (i++; i <= count; i += i & (0 - i)) tree[i] += delta;
+	};
+	auto prefix = [&](size_t i) {
+		long long sum = 0;
+		for (; i > 0; i -= i & (0 - i)) sum += tree[i];
+		return sum;
+	};
+	for (size_t i = 0; i < count; i++) {
+		add(i, 1);
+	}
+
+	double total = 0;
+	size_t worst = 0;
+	int key;
+	for (size_t remaining = count; queue.getMax(key); remaining--) {
+		size_t larger = remaining - prefix(key + 1);
+		total += larger;
+		worst = std::max(worst, larger);
+		add(key, -1);
+	}
+	return { count ? total / count : 0.0, worst };
+}
+
+void benchmarkMultiQueue(int threadCount, size_t opsPerThread) {
+	auto run = [&](auto insert, auto pop) {
+		auto start = std::chrono::steady_clock::now();
+		vector<std::thread> threads;
+		for (int t = 0; t < threadCount; t++) {
+			threads.emplace_back([&, t]() {
+				std::mt19937 rng(t);
+				for (size_t i = 0; i < opsPerThread; i++) {
+					if (i % 2 == 0) insert((int)rng());
+					else pop();
+				}
+			});
+		}
+		for (auto& thread : threads) {
+			thread.join();
+		}
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		return threadCount * opsPerThread / seconds;
+	};
+
+	std::mutex lock;
+	DaryHeap<int, 4> shared;
+	double lockedRate = run(
+		[&](int key) { std::lock_guard<std::mutex> guard(lock); shared.insert(key); },
+		[&]() { std::lock_guard<std::mutex> guard(lock); if (not shared.empty()) shared.getMax(); });
+
+	MultiQueue<int> multi(threadCount);
+	double multiRate = run(
+		[&](int key) { multi.insert(key); },
+		[&]() { int key; multi.getMax(key); });
+
+	MultiQueue<int> sample(threadCount);
+	auto rankError = measureRankError(sample, 1000000);
+
+	std::cout << "threads: " << threadCount << "\n";
+	std::cout << "locked DaryHeap: " << lockedRate << " ops/s\n";
+	std::cout << "MultiQueue:      " << multiRate << " ops/s, rank error mean " << rankError.first << ", max " << rankError.second << "\n";
+}
+
+
 std::vector<int> readIntegersFromFile(const std::string& filename) {
     std::ifstream file(filename);
     std::vector<int> numbersVec;
@@ -123,6 +1003,9 @@ std::vector<int> readIntegersFromFile(const std::string& filename) {
 }
 
 int main(int argc, char* argv[]) {
+	//benchmarkHeaps(10000000);
+	//benchmarkMonotoneQueues(10000000);
+	//benchmarkMultiQueue(8, 10000000);
     if( argc != 3 ){
         std::cerr << "Not enough arguments\n";
         return 1;
@@ -1,5 +1,14 @@
 #include<iostream>
 #include<vector>
+#include<chrono>
+#include<random>
+#include<algorithm>
+#include<complex>
+#include<cmath>
+#include<cstdint>
+#ifdef __SSE2__
+#include<immintrin.h>
+#endif
 
 using std::vector;
 
@@ -22,6 +31,353 @@ double Horner(const vector<double>& coeff, double x) {
 	return res;
 }
 
+// Horner run on several points at once, one SIMD lane per point, so the dependent multiply-adds of
+// different points overlap. Results go to out[0..count).
+void HornerBatch(const vector<double>& coeff, const double* xs, double* out, size_t count) {
+	if (coeff.empty()) {
+		std::fill(out, out + count, 0.0);
+		return;
+	}
+	const int top = (int)coeff.size() - 1;
+	size_t i = 0;
+#if defined(__AVX__)
+	for (; i + 8 <= count; i += 8) {
+		__m256d x0 = _mm256_loadu_pd(xs + i);
+		__m256d x1 = _mm256_loadu_pd(xs + i + 4);
+		__m256d r0 = _mm256_set1_pd(coeff[top]);
+		__m256d r1 = r0;
+		for (int k = top - 1; k >= 0; k--) {
+			__m256d c = _mm256_set1_pd(coeff[k]);
+#if defined(__FMA__)
+			r0 = _mm256_fmadd_pd(r0, x0, c);
+			r1 = _mm256_fmadd_pd(r1, x1, c);
+#else
+			r0 = _mm256_add_pd(_mm256_mul_pd(r0, x0), c);
+			r1 = _mm256_add_pd(_mm256_mul_pd(r1, x1), c);
+#endif
+		}
+		_mm256_storeu_pd(out + i, r0);
+		_mm256_storeu_pd(out + i + 4, r1);
+	}
+#elif defined(__SSE2__)
+	for (; i + 4 <= count; i += 4) {
+		__m128d x0 = _mm_loadu_pd(xs + i);
+		__m128d x1 = _mm_loadu_pd(xs + i + 2);
+		__m128d r0 = _mm_set1_pd(coeff[top]);
+		__m128d r1 = r0;
+		for (int k = top - 1; k >= 0; k--) {
+			__m128d c = _mm_set1_pd(coeff[k]);
+			r0 = _mm_add_pd(_mm_mul_pd(r0, x0), c);
+			r1 = _mm_add_pd(_mm_mul_pd(r1, x1), c);
+		}
+		_mm_storeu_pd(out + i, r0);
+		_mm_storeu_pd(out + i + 2, r1);
+	}
+#endif
+	for (; i < count; i++) {
+		out[i] = Horner(coeff, xs[i]);
+	}
+}
+
+vector<double> HornerBatch(const vector<double>& coeff, const vector<double>& xs) {
+	vector<double> res(xs.size());
+	HornerBatch(coeff, xs.data(), res.data(), xs.size());
+	return res;
+}
+
+// Estrin scheme for one point: blocks of 8 coefficients are evaluated as a tree of independent
+// multiply-adds and the blocks are combined by Horner in x^8, giving a shorter dependency chain
+double Estrin(const vector<double>& coeff, double x) {
+	const size_t n = coeff.size();
+	auto c = [&](size_t k) { return k < n ? coeff[k] : 0.0; };
+	double x2 = x * x;
+	double x4 = x2 * x2;
+	double x8 = x4 * x4;
+
+	double res = 0;
+	for (size_t block = (n + 7) / 8; block-- > 0;) {
+		size_t k = block * 8;
+		double p01 = c(k) + c(k + 1) * x;
+		double p23 = c(k + 2) + c(k + 3) * x;
+		double p45 = c(k + 4) + c(k + 5) * x;
+		double p67 = c(k + 6) + c(k + 7) * x;
+		double b = (p01 + p23 * x2) + (p45 + p67 * x2) * x4;
+		res = res * x8 + b;
+	}
+	return res;
+}
+
+// Polynomial multiplication and multipoint evaluation. Coefficients follow Horner's convention,
+// coeff[k] belongs to x^k.
+
+void fft(vector<std::complex<double>>& a, bool invert) {
+	const size_t n = a.size();
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) std::swap(a[i], a[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1) {
+		double angle = 2 * std::acos(-1.0) / len * (invert ? -1 : 1);
+		std::complex<double> wlen(std::cos(angle), std::sin(angle));
+		for (size_t i = 0; i < n; i += len) {
+			std::complex<double> w(1);
+			for (size_t j = 0; j < len / 2; j++) {
+				std::complex<double> u = a[i + j];
+				std::complex<double> v = a[i + j + len / 2] * w;
+				a[i + j] = u + v;
+				a[i + j + len / 2] = u - v;
+				w *= wlen;
+			}
+		}
+	}
+	if (invert) {
+		for (auto& x : a) {
+			x /= (double)n;
+		}
+	}
+}
+
+const size_t SCHOOLBOOK_LIMIT = 32;
+
+vector<double> polyMultiply(const vector<double>& a, const vector<double>& b) {
+	if (a.empty() or b.empty()) return {};
+	vector<double> res(a.size() + b.size() - 1, 0.0);
+	if (std::min(a.size(), b.size()) <= SCHOOLBOOK_LIMIT) {
+		for (size_t i = 0; i < a.size(); i++) {
+			for (size_t j = 0; j < b.size(); j++) {
+				res[i + j] += a[i] * b[j];
+			}
+		}
+		return res;
+	}
+	size_t n = 1;
+	while (n < res.size()) n <<= 1;
+	vector<std::complex<double>> fa(a.begin(), a.end());
+	vector<std::complex<double>> fb(b.begin(), b.end());
+	fa.resize(n);
+	fb.resize(n);
+	fft(fa, false);
+	fft(fb, false);
+	for (size_t i = 0; i < n; i++) {
+		fa[i] *= fb[i];
+	}
+	fft(fa, true);
+	for (size_t i = 0; i < res.size(); i++) {
+		res[i] = fa[i].real();
+	}
+	return res;
+}
+
+// Exact arithmetic modulo the NTT prime 998244353 = 119 * 2^23 + 1
+const uint32_t MOD = 998244353;
+const uint32_t MOD_ROOT = 3;
+
+using PolyMod = vector<uint32_t>;
+
+// Coefficients and points may be any uint32_t, the public functions reduce them so that
+// the NTT paths agree with the schoolbook and Horner ones
+void reduceMod(PolyMod& a) {
+	for (auto& x : a) {
+		if (x >= MOD) x %= MOD;
+	}
+}
+
+uint32_t powMod(uint64_t base, uint64_t exponent) {
+	uint64_t res = 1;
+	base %= MOD;
+	while (exponent > 0) {
+		if (exponent & 1) res = res * base % MOD;
+		base = base * base % MOD;
+		exponent >>= 1;
+	}
+	return (uint32_t)res;
+}
+
+void ntt(PolyMod& a, bool invert) {
+	const size_t n = a.size();
+	for (size_t i = 1, j = 0; i < n; i++) {
+		size_t bit = n >> 1;
+		for (; j & bit; bit >>= 1) {
+			j ^= bit;
+		}
+		j ^= bit;
+		if (i < j) std::swap(a[i], a[j]);
+	}
+	for (size_t len = 2; len <= n; len <<= 1) {
+		uint64_t wlen = powMod(MOD_ROOT, (MOD - 1) / len);
+		if (invert) wlen = powMod(wlen, MOD - 2);
+		for (size_t i = 0; i < n; i += len) {
+			uint64_t w = 1;
+			for (size_t j = 0; j < len / 2; j++) {
+				uint32_t u = a[i + j];
+				uint32_t v = (uint32_t)(a[i + j + len / 2] * w % MOD);
+				a[i + j] = u + v < MOD ? u + v : u + v - MOD;
+				a[i + j + len / 2] = u >= v ? u - v : u + MOD - v;
+				w = w * wlen % MOD;
+			}
+		}
+	}
+	if (invert) {
+		uint64_t nInverse = powMod(n, MOD - 2);
+		for (auto& x : a) {
+			x = (uint32_t)(x * nInverse % MOD);
+		}
+	}
+}
+
+PolyMod polyMultiplyMod(const PolyMod& a, const PolyMod& b) {
+	if (a.empty() or b.empty()) return {};
+	size_t resultSize = a.size() + b.size() - 1;
+	if (std::min(a.size(), b.size()) <= SCHOOLBOOK_LIMIT) {
+		vector<uint64_t> acc(resultSize, 0);
+		for (size_t i = 0; i < a.size(); i++) {
+			for (size_t j = 0; j < b.size(); j++) {
+				acc[i + j] = (acc[i + j] + (uint64_t)a[i] * b[j]) % MOD;
+			}
+		}
+		return PolyMod(acc.begin(), acc.end());
+	}
+	size_t n = 1;
+	while (n < resultSize) n <<= 1;
+	PolyMod fa = a;
+	PolyMod fb = b;
+	reduceMod(fa);
+	reduceMod(fb);
+	fa.resize(n);
+	fb.resize(n);
+	ntt(fa, false);
+	ntt(fb, false);
+	for (size_t i = 0; i < n; i++) {
+		fa[i] = (uint32_t)((uint64_t)fa[i] * fb[i] % MOD);
+	}
+	ntt(fa, true);
+	fa.resize(resultSize);
+	return fa;
+}
+
+// First n coefficients of 1 / a by Newton iteration, a[0] must be non-zero
+PolyMod polyInverseMod(const PolyMod& a, size_t n) {
+	PolyMod b = { powMod(a[0], MOD - 2) };
+	while (b.size() < n) {
+		size_t next = std::min(b.size() * 2, n);
+		PolyMod prefix(a.begin(), a.begin() + std::min(a.size(), next));
+		PolyMod ab = polyMultiplyMod(prefix, b);
+		ab.resize(next);
+		for (auto& x : ab) {
+			x = x == 0 ? 0 : MOD - x;
+		}
+		ab[0] = (ab[0] + 2) % MOD;
+		b = polyMultiplyMod(b, ab);
+		b.resize(next);
+	}
+	b.resize(n);
+	return b;
+}
+
+// a mod b, the leading coefficient of b must be non-zero
+PolyMod polyRemainderMod(const PolyMod& input, const PolyMod& b) {
+	PolyMod a = input;
+	reduceMod(a);
+	if (a.size() < b.size()) return a;
+	size_t quotientSize = a.size() - b.size() + 1;
+	PolyMod ra(a.rbegin(), a.rbegin() + quotientSize);
+	PolyMod rb(b.rbegin(), b.rend());
+	PolyMod q = polyMultiplyMod(ra, polyInverseMod(rb, quotientSize));
+	q.resize(quotientSize);
+	std::reverse(q.begin(), q.end());
+	PolyMod bq = polyMultiplyMod(b, q);
+	PolyMod r(b.size() - 1);
+	for (size_t i = 0; i < r.size(); i++) {
+		r[i] = a[i] >= bq[i] ? a[i] - bq[i] : a[i] + MOD - bq[i];
+	}
+	return r;
+}
+
+uint32_t HornerMod(const PolyMod& coeff, uint32_t x) {
+	uint64_t res = 0;
+	for (size_t k = coeff.size(); k-- > 0;) {
+		res = (res * x + coeff[k]) % MOD;
+	}
+	return (uint32_t)res;
+}
+
+// Subproduct tree over points[lo, hi): node holds the product of (x - points[i])
+void buildSubproductTree(vector<PolyMod>& tree, size_t node, const PolyMod& points, size_t lo, size_t hi) {
+	if (hi - lo == 1) {
+		tree[node] = { points[lo] == 0 ? 0 : MOD - points[lo], 1 };
+		return;
+	}
+	size_t mid = (lo + hi) / 2;
+	buildSubproductTree(tree, 2 * node, points, lo, mid);
+	buildSubproductTree(tree, 2 * node + 1, points, mid, hi);
+	tree[node] = polyMultiplyMod(tree[2 * node], tree[2 * node + 1]);
+}
+
+const size_t MULTIPOINT_LEAF = 64;
+
+void evaluateDown(const vector<PolyMod>& tree, size_t node, const PolyMod& remainder, const PolyMod& points, size_t lo, size_t hi, PolyMod& out) {
+	if (hi - lo <= MULTIPOINT_LEAF) {
+		for (size_t i = lo; i < hi; i++) {
+			out[i] = HornerMod(remainder, points[i]);
+		}
+		return;
+	}
+	size_t mid = (lo + hi) / 2;
+	evaluateDown(tree, 2 * node, polyRemainderMod(remainder, tree[2 * node]), points, lo, mid, out);
+	evaluateDown(tree, 2 * node + 1, polyRemainderMod(remainder, tree[2 * node + 1]), points, mid, hi, out);
+}
+
+// Values of coeff at all points modulo MOD in O(n log^2 n), small inputs use Horner per point
+PolyMod multipointEvaluateMod(const PolyMod& coeff, const PolyMod& points) {
+	PolyMod out(points.size());
+	if (coeff.size() <= MULTIPOINT_LEAF or points.size() <= MULTIPOINT_LEAF or (uint64_t)coeff.size() * points.size() <= (1ull << 22)) {
+		for (size_t i = 0; i < points.size(); i++) {
+			out[i] = HornerMod(coeff, points[i]);
+		}
+		return out;
+	}
+	PolyMod reducedPoints = points;
+	reduceMod(reducedPoints);
+	vector<PolyMod> tree(4 * points.size());
+	buildSubproductTree(tree, 1, reducedPoints, 0, points.size());
+	evaluateDown(tree, 1, polyRemainderMod(coeff, tree[1]), reducedPoints, 0, points.size(), out);
+	return out;
+}
+
+void benchmarkPolynomials(size_t degree, size_t points) {
+	std::mt19937 rng(42);
+	std::uniform_real_distribution<double> dist(-1.0, 1.0);
+	vector<double> coeff(degree + 1);
+	for (auto& c : coeff) {
+		c = dist(rng);
+	}
+	vector<double> xs(points);
+	for (auto& x : xs) {
+		x = dist(rng);
+	}
+	vector<double> out(points);
+
+	auto report = [&](const char* name, auto evaluate) {
+		auto start = std::chrono::steady_clock::now();
+		evaluate();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		double checksum = 0;
+		for (const double v : out) {
+			checksum += v;
+		}
+		std::cout << name << ": " << points / seconds << " evaluations/s (checksum " << checksum << ")\n";
+	};
+
+	report("evaluatePolynomial", [&]() { for (size_t i = 0; i < points; i++) out[i] = evaluatePolynomial(coeff, xs[i]); });
+	report("Horner            ", [&]() { for (size_t i = 0; i < points; i++) out[i] = Horner(coeff, xs[i]); });
+	report("Estrin            ", [&]() { for (size_t i = 0; i < points; i++) out[i] = Estrin(coeff, xs[i]); });
+	report("HornerBatch       ", [&]() { HornerBatch(coeff, xs.data(), out.data(), points); });
+}
+
 void test_polynomials() {
 	vector<double> c = { 1, 1, 1 };
 	std::cout << Horner(c, 1) << " " << evaluatePolynomial(c, 1) << "\n";
@@ -66,6 +422,7 @@ void printVec(const vector<int>& data) {
 
 int main() {
 	test_polynomials();
+	//benchmarkPolynomials(64, 10000000);
 
 	auto res = combinations(6, 3);
 	for (const auto& line : res) {
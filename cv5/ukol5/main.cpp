@@ -1,114 +1,678 @@
 #include <iostream>
 #include <vector>
 #include <algorithm>
+#include <iterator>
 #include <fstream>
 #include <sstream>
+#include <cstdint>
+#include <thread>
+#include <stdexcept>
+#include <climits>
+#include <atomic>
+#include <map>
+#include <unordered_map>
+#include <queue>
+#include <cstdio>
+#include <cstdlib>
 using namespace std;
-vector<vector<int>> readSimplicesFromFile(const string& filename) {
+// Calls visit for the simplex on every non-empty line, returns false if the file cannot be opened
+template <typename Visit>
+bool forEachSimplexInFile(const string& filename, Visit visit) {
     ifstream file(filename);
-    vector<vector<int>> simplices;
     if (!file.is_open()) {
         cerr << "Unable to open file: " << filename << endl;
-        return simplices;
+        return false;
     }
     string line;
+    vector<int> simplex;
     while (getline(file, line)) {
         stringstream lineAsStream(line);
         int num;
-        vector<int> simplex;
+        simplex.clear();
         while (lineAsStream >> num) {
             simplex.push_back(num);
         }
-        if (!simplex.empty()) simplices.push_back(simplex);
+        if (!simplex.empty()) visit(simplex);
     }
     file.close();
+    return true;
+}
+
+vector<vector<int>> readSimplicesFromFile(const string& filename) {
+    vector<vector<int>> simplices;
+    forEachSimplexInFile(filename, [&](const vector<int>& simplex) {
+        simplices.push_back(simplex);
+    });
     return simplices;
 }
+// Number of k-subsets of n elements, saturates at UINT64_MAX
+uint64_t binomial(int n, int k) {
+    if (k < 0 or k > n) return 0;
+    k = min(k, n - k);
+    unsigned __int128 res = 1;
+    for (int i = 0; i < k; i++) {
+        res = res * (n - i) / (i + 1);
+        if (res > UINT64_MAX) return UINT64_MAX;
+    }
+    return (uint64_t)res;
+}
+
+// Ranks are 64-bit, so rank arithmetic needs the exact count
+uint64_t checkedBinomial(int n, int k) {
+    uint64_t res = binomial(n, k);
+    if (res == UINT64_MAX) {
+        throw overflow_error("C(" + to_string(n) + ", " + to_string(k) + ") does not fit in 64 bits");
+    }
+    return res;
+}
+
+// Position of a sorted combination in the lexicographic order produced by CombinationGenerator
+uint64_t rankCombination(const vector<int>& comb, int n) {
+    int k = (int)comb.size();
+    uint64_t total = checkedBinomial(n, k);
+    uint64_t complement = 0;
+    for (int i = 0; i < k; i++) {
+        complement += binomial(n - 1 - comb[i], k - i);
+    }
+    return total - 1 - complement;
+}
+
+// Inverse of rankCombination, greedy decomposition in the combinatorial number system
+vector<int> unrankCombination(uint64_t rank, int n, int k) {
+    vector<int> comb(k);
+    uint64_t x = checkedBinomial(n, k) - 1 - rank;
+    int m = n - 1;
+    for (int i = 0; i < k; i++) {
+        while (binomial(m, k - i) > x) {
+            m--;
+        }
+        x -= binomial(m, k - i);
+        comb[i] = n - 1 - m;
+        m--;
+    }
+    return comb;
+}
+
+// Lazily walks the k-subsets of {0..n-1} in lexicographic order, reusing one buffer
+class CombinationGenerator {
+private:
+    int n, k;
+    vector<int> current;
+    bool valid;
+
+public:
+    // Rank 0 starts at {0..k-1} directly, so it works for any n and k, other ranks need C(n, k) to fit in 64 bits
+    CombinationGenerator(int n, int k, uint64_t startRank = 0) : n(n), k(k), valid(k >= 0 and k <= n) {
+        if (not valid) return;
+        if (startRank == 0) {
+            current.resize(k);
+            for (int i = 0; i < k; i++) current[i] = i;
+            return;
+        }
+        valid = startRank < checkedBinomial(n, k);
+        if (valid) current = unrankCombination(startRank, n, k);
+    }
+
+    bool done() const {
+        return not valid;
+    }
+
+    const vector<int>& get() const {
+        return current;
+    }
+
+    // Advances to the next combination, returns false past the last one
+    bool next() {
+        int i = k - 1;
+        while (i >= 0 and current[i] == n - k + i) {
+            i--;
+        }
+        if (i < 0) {
+            valid = false;
+            return false;
+        }
+        current[i] += 1;
+        for (int j = i + 1; j < k; j++) {
+            current[j] = current[j - 1] + 1;
+        }
+        return true;
+    }
+};
+
+// Splits the enumeration into contiguous rank ranges, each thread unranks its start and walks on
+template <typename Visit>
+void parallelForEachCombination(int n, int k, int threadCount, Visit visit) {
+    uint64_t total = checkedBinomial(n, k);
+    threadCount = max(1, threadCount);
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        uint64_t first = (unsigned __int128)total * t / threadCount;
+        uint64_t last = (unsigned __int128)total * (t + 1) / threadCount;
+        threads.emplace_back([=, &visit]() {
+            if (first == last) return;
+            CombinationGenerator gen(n, k, first);
+            for (uint64_t r = first; r < last; r++, gen.next()) {
+                visit(t, gen.get());
+            }
+        });
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+// Visits every k-subset of {0..n-1} as a bitmask, in increasing numeric order, using Gosper's hack.
+// No allocation, n must fit in the word.
+template <typename Visit>
+void forEachSubsetMask(int n, int k, Visit visit) {
+    if (n > 64) {
+        throw invalid_argument("forEachSubsetMask supports at most 64 elements");
+    }
+    if (k < 0 or k > n) return;
+    if (k == 0) {
+        visit(uint64_t(0));
+        return;
+    }
+    uint64_t mask = k == 64 ? ~uint64_t(0) : (uint64_t(1) << k) - 1;
+    while (true) {
+        visit(mask);
+        int shift = __builtin_ctzll(mask);
+        uint64_t ripple = mask + (uint64_t(1) << shift);
+        if (ripple == 0) return;
+        mask = (((ripple ^ mask) >> 2) >> shift) | ripple;
+        if (n < 64 and (mask >> n) != 0) return;
+    }
+}
+
 vector<vector<int>> combinations(int n, int k) {
-	vector<vector<int>> res;
-	if (k < 0 or k > n) {
-		return res;
-	}
-	vector<int> currentComb;
-	currentComb.reserve(k);
-	for (int i = 0; i < k; i++) {
-		currentComb.push_back(i);
-	}
-	
-	while (true) {
-		res.push_back(currentComb);
-		int i = k - 1;
-		while (i >= 0 and currentComb[i] == n - k + i) {
-			i--;
-		}
-		if (i < 0) {
-			break;
-		}
-		currentComb[i] += 1;
-		for (size_t j = i + 1; j < currentComb.size(); j++) {
-			currentComb[j] = currentComb[j - 1] + 1;
-		}
-	}
-	return res;
-}
-void findBoundary(const string& filename) {
-    vector<vector<int>> inputSimplices = readSimplicesFromFile(filename);
-    if (inputSimplices.empty()) {
-        cerr << "No simplices found in file.\n";
+    vector<vector<int>> res;
+    for (CombinationGenerator gen(n, k); not gen.done(); gen.next()) {
+        res.push_back(gen.get());
+    }
+    return res;
+}
+struct ComplexSummary {
+    vector<long long> countByDim;
+    vector<vector<int>> boundaryFaces;
+};
+
+// Simplex of up to 4 vertices in 128 bits. Vertex i, order-preserving mapped to unsigned and shifted
+// by one (0 marks an empty slot), sits in the i-th 32-bit slot from the top, so comparing keys
+// compares vertex lists lexicographically.
+const int PACKED_MAX_VERTICES = 4;
+
+struct PackedSimplex {
+    uint64_t hi, lo;
+
+    bool operator==(const PackedSimplex& other) const {
+        return hi == other.hi and lo == other.lo;
+    }
+
+    bool operator<(const PackedSimplex& other) const {
+        return hi != other.hi ? hi < other.hi : lo < other.lo;
+    }
+
+    uint32_t slot(int i) const {
+        uint64_t word = i < 2 ? hi : lo;
+        return (uint32_t)(word >> (i % 2 == 0 ? 32 : 0));
+    }
+
+    int size() const {
+        int n = 0;
+        while (n < PACKED_MAX_VERTICES and slot(n) != 0) n++;
+        return n;
+    }
+
+    int vertex(int i) const {
+        return (int)((slot(i) - 1) ^ 0x80000000u);
+    }
+};
+
+bool canPack(const vector<int>& sortedSimplex) {
+    if (sortedSimplex.size() > PACKED_MAX_VERTICES) return false;
+    for (size_t i = 0; i < sortedSimplex.size(); i++) {
+        if (sortedSimplex[i] == INT_MAX) return false;
+        if (i > 0 and sortedSimplex[i] == sortedSimplex[i - 1]) return false;
+    }
+    return true;
+}
+
+// Packs the vertices of v selected by mask, v must be sorted
+PackedSimplex packSimplex(const int* v, int n, uint32_t mask) {
+    uint64_t slots[PACKED_MAX_VERTICES] = { 0, 0, 0, 0 };
+    int k = 0;
+    for (int i = 0; i < n; i++) {
+        if (mask & (1u << i)) {
+            slots[k++] = ((uint32_t)v[i] ^ 0x80000000u) + 1;
+        }
+    }
+    return { slots[0] << 32 | slots[1], slots[2] << 32 | slots[3] };
+}
+
+uint64_t mixBits(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ull;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ull;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBull;
+    return x ^ (x >> 31);
+}
+
+uint64_t hashPacked(const PackedSimplex& key) {
+    return mixBits(key.hi ^ mixBits(key.lo));
+}
+
+template <typename Work>
+void runOnThreads(int threadCount, Work work) {
+    if (threadCount <= 1) {
+        work(0);
         return;
     }
-    vector<vector<int>> simplices;
-    for (auto s : inputSimplices) {
-        sort(s.begin(), s.end());
-        simplices.push_back(s);
-        int n = (int)s.size();
-        for (int k = 1; k < n; ++k) {
-            auto combs = combinations(n, k);
-            for (auto &idxs : combs) {
-                vector<int> subs;
-                for (int i : idxs) {
-                    subs.push_back(s[i]);
-                }
-                simplices.push_back(subs);
+    vector<thread> threads;
+    for (int t = 0; t < threadCount; t++) {
+        threads.emplace_back(work, t);
+    }
+    for (auto& th : threads) {
+        th.join();
+    }
+}
+
+// Open-addressing hash map (linear probing) from packed simplex to its number of occurrences
+class PackedSimplexCounter {
+private:
+    vector<PackedSimplex> keys;
+    vector<uint32_t> counts;
+    size_t used;
+
+    size_t findSlot(const PackedSimplex& key) const {
+        size_t mask = keys.size() - 1;
+        size_t i = hashPacked(key) & mask;
+        while (keys[i].hi != 0 and not (keys[i] == key)) {
+            i = (i + 1) & mask;
+        }
+        return i;
+    }
+
+    void grow() {
+        vector<PackedSimplex> oldKeys(keys.size() * 2, PackedSimplex{ 0, 0 });
+        vector<uint32_t> oldCounts(counts.size() * 2, 0);
+        oldKeys.swap(keys);
+        oldCounts.swap(counts);
+        for (size_t i = 0; i < oldKeys.size(); i++) {
+            if (oldKeys[i].hi == 0) continue;
+            size_t slot = findSlot(oldKeys[i]);
+            keys[slot] = oldKeys[i];
+            counts[slot] = oldCounts[i];
+        }
+    }
+
+public:
+    explicit PackedSimplexCounter(size_t expected) : used(0) {
+        size_t capacity = 16;
+        while (capacity < expected * 2) capacity <<= 1;
+        keys.assign(capacity, PackedSimplex{ 0, 0 });
+        counts.assign(capacity, 0);
+    }
+
+    // Returns the count after adding this occurrence
+    uint32_t add(const PackedSimplex& key) {
+        if ((used + 1) * 2 > keys.size()) grow();
+        size_t slot = findSlot(key);
+        if (keys[slot].hi == 0) {
+            keys[slot] = key;
+            used++;
+        }
+        return ++counts[slot];
+    }
+
+    size_t size() const {
+        return used;
+    }
+
+    template <typename Visit>
+    void forEach(Visit visit) const {
+        for (size_t i = 0; i < keys.size(); i++) {
+            if (keys[i].hi != 0) visit(keys[i], counts[i]);
+        }
+    }
+};
+
+// Hash-based face counting on packed keys, returns false when some simplex cannot be packed.
+// Every thread expands its own slice of the input into thread-local buffers split into shards by
+// key hash, so equal keys always meet in the same shard and each shard is counted by one thread.
+bool summarizePacked(const vector<vector<int>>& inputSimplices, ComplexSummary& res, int threadCount = 1) {
+    int shards = max(1, threadCount);
+    auto shardOf = [shards](const PackedSimplex& key) {
+        return (int)((hashPacked(key) >> 32) % shards);
+    };
+    // buffers[t][s] holds the keys thread t produced for shard s
+    typedef vector<vector<vector<PackedSimplex>>> ShardBuffers;
+    ShardBuffers simplexBuffers(shards, vector<vector<PackedSimplex>>(shards));
+    ShardBuffers faceBuffers(shards, vector<vector<PackedSimplex>>(shards));
+    vector<vector<long long>> localCounts(shards);
+    vector<vector<PackedSimplex>> boundary(shards);
+    atomic<bool> packable(true);
+
+    runOnThreads(shards, [&](int t) {
+        size_t first = inputSimplices.size() * t / shards;
+        size_t last = inputSimplices.size() * (t + 1) / shards;
+        vector<int> s;
+        for (size_t i = first; i < last and packable; i++) {
+            s = inputSimplices[i];
+            sort(s.begin(), s.end());
+            if (not canPack(s)) {
+                packable = false;
+                return;
+            }
+            int n = (int)s.size();
+            for (uint32_t mask = 1; mask < (1u << n); mask++) {
+                PackedSimplex key = packSimplex(s.data(), n, mask);
+                simplexBuffers[t][shardOf(key)].push_back(key);
+            }
+        }
+    });
+    if (not packable) return false;
+
+    runOnThreads(shards, [&](int shard) {
+        size_t total = 0;
+        for (int t = 0; t < shards; t++) total += simplexBuffers[t][shard].size();
+        PackedSimplexCounter simplices(total / 2);
+        for (int t = 0; t < shards; t++) {
+            for (const auto& key : simplexBuffers[t][shard]) simplices.add(key);
+            vector<PackedSimplex>().swap(simplexBuffers[t][shard]);
+        }
+        vector<long long>& countByDim = localCounts[shard];
+        simplices.forEach([&](const PackedSimplex& key, uint32_t) {
+            int n = key.size();
+            if ((int)countByDim.size() < n) countByDim.resize(n, 0);
+            countByDim[n - 1]++;
+            if (n <= 1) return;
+            int v[PACKED_MAX_VERTICES];
+            for (int i = 0; i < n; i++) v[i] = key.vertex(i);
+            uint32_t all = (1u << n) - 1;
+            for (int omit = 0; omit < n; omit++) {
+                PackedSimplex face = packSimplex(v, n, all & ~(1u << omit));
+                faceBuffers[shard][shardOf(face)].push_back(face);
             }
+        });
+    });
+
+    runOnThreads(shards, [&](int shard) {
+        size_t total = 0;
+        for (int t = 0; t < shards; t++) total += faceBuffers[t][shard].size();
+        PackedSimplexCounter faces(total / 2);
+        for (int t = 0; t < shards; t++) {
+            for (const auto& key : faceBuffers[t][shard]) faces.add(key);
+            vector<PackedSimplex>().swap(faceBuffers[t][shard]);
         }
+        faces.forEach([&](const PackedSimplex& key, uint32_t count) {
+            if (count == 1) boundary[shard].push_back(key);
+        });
+        sort(boundary[shard].begin(), boundary[shard].end());
+    });
+
+    for (const auto& counts : localCounts) {
+        if (res.countByDim.size() < counts.size()) res.countByDim.resize(counts.size(), 0);
+        for (size_t d = 0; d < counts.size(); d++) res.countByDim[d] += counts[d];
     }
-    sort(simplices.begin(), simplices.end());
-    simplices.erase(unique(simplices.begin(), simplices.end()), simplices.end());
-    
-    if (simplices.empty()) {
-        cout << "No simplices provided.\n";
-        return;
+    vector<PackedSimplex> merged;
+    for (const auto& part : boundary) {
+        size_t middle = merged.size();
+        merged.insert(merged.end(), part.begin(), part.end());
+        inplace_merge(merged.begin(), merged.begin() + middle, merged.end());
     }
-    int maxDim = 0;
-    for (const auto &s : simplices) {
-        int dim = (int)s.size() - 1;
-        maxDim = max(maxDim, dim);
+    for (const auto& key : merged) {
+        vector<int> face(key.size());
+        for (size_t i = 0; i < face.size(); i++) face[i] = key.vertex(i);
+        res.boundaryFaces.push_back(face);
     }
-    vector<int> countByDim(maxDim + 1, 0);
-    for (const auto &s : simplices) {
-        int dim = (int)s.size() - 1;
-        countByDim[dim]++;
+    return true;
+}
+
+// Simplex tree: trie over sorted vertex sequences, every node is one simplex of the complex.
+// Siblings are kept in a sorted linked list (vertices of the root level in a map), so a preorder
+// walk lists the simplices lexicographically. Nodes with the same vertex are chained for cofaces.
+class SimplexTree {
+private:
+    struct Node {
+        int vertex;
+        int dimension;
+        int parent;
+        int firstChild;
+        int nextSibling;
+        int nextSameVertex;
+    };
+    static constexpr int NONE = -1;
+
+    vector<Node> nodes;
+    map<int, int> roots;
+    unordered_map<int, int> lastWithVertex;
+    vector<long long> countByDim;
+
+    int createNode(int vertex, int parent, int nextSibling) {
+        int dimension = parent == NONE ? 0 : nodes[parent].dimension + 1;
+        auto last = lastWithVertex.find(vertex);
+        int nextSameVertex = last == lastWithVertex.end() ? NONE : last->second;
+        nodes.push_back({ vertex, dimension, parent, NONE, nextSibling, nextSameVertex });
+        int index = (int)nodes.size() - 1;
+        lastWithVertex[vertex] = index;
+        if ((int)countByDim.size() <= dimension) countByDim.resize(dimension + 1, 0);
+        countByDim[dimension]++;
+        return index;
     }
-    vector<vector<int>> allFaces;
-    for (const auto &s : simplices) {
-        int n = (int)s.size();
-        if (n <= 1) continue;
-        auto combs = combinations(n, n - 1);
-        for (auto &idxs : combs) {
-            vector<int> face;
-            for (int i : idxs) face.push_back(s[i]);
-            allFaces.push_back(face);
+
+    int child(int node, int vertex) const {
+        if (node == NONE) {
+            auto it = roots.find(vertex);
+            return it == roots.end() ? NONE : it->second;
         }
+        int cur = nodes[node].firstChild;
+        while (cur != NONE and nodes[cur].vertex < vertex) {
+            cur = nodes[cur].nextSibling;
+        }
+        return cur != NONE and nodes[cur].vertex == vertex ? cur : NONE;
     }
-    sort(allFaces.begin(), allFaces.end());
-    vector<vector<int>> boundaryFaces;
-    for (size_t i = 0; i < allFaces.size(); ) {
-        size_t j = i + 1;
-        while (j < allFaces.size() && allFaces[j] == allFaces[i]) j++;
-        if (j - i == 1) boundaryFaces.push_back(allFaces[i]);
-        i = j;
+
+    int childOrCreate(int node, int vertex) {
+        if (node == NONE) {
+            auto it = roots.find(vertex);
+            if (it != roots.end()) return it->second;
+            int created = createNode(vertex, NONE, NONE);
+            roots[vertex] = created;
+            return created;
+        }
+        int prev = NONE;
+        int cur = nodes[node].firstChild;
+        while (cur != NONE and nodes[cur].vertex < vertex) {
+            prev = cur;
+            cur = nodes[cur].nextSibling;
+        }
+        if (cur != NONE and nodes[cur].vertex == vertex) return cur;
+        int created = createNode(vertex, node, cur);
+        if (prev == NONE) nodes[node].firstChild = created;
+        else nodes[prev].nextSibling = created;
+        return created;
+    }
+
+    // Inserts every subsequence of simplex[begin..] below node
+    void insertFaces(int node, const vector<int>& simplex, size_t begin) {
+        for (size_t i = begin; i < simplex.size(); i++) {
+            int next = childOrCreate(node, simplex[i]);
+            insertFaces(next, simplex, i + 1);
+        }
+    }
+
+    void verticesOf(int node, vector<int>& out) const {
+        out.clear();
+        for (; node != NONE; node = nodes[node].parent) {
+            out.push_back(nodes[node].vertex);
+        }
+        reverse(out.begin(), out.end());
+    }
+
+    // Does the path from the root to node contain every vertex of sortedSimplex
+    bool pathContains(int node, const vector<int>& sortedSimplex) const {
+        int j = (int)sortedSimplex.size() - 1;
+        for (; node != NONE and j >= 0; node = nodes[node].parent) {
+            if (nodes[node].vertex == sortedSimplex[j]) j--;
+            else if (nodes[node].vertex < sortedSimplex[j]) return false;
+        }
+        return j < 0;
+    }
+
+    template <typename Visit>
+    void visitSubtree(int node, vector<int>& path, Visit& visit) const {
+        path.push_back(nodes[node].vertex);
+        visit(node, path);
+        for (int c = nodes[node].firstChild; c != NONE; c = nodes[c].nextSibling) {
+            visitSubtree(c, path, visit);
+        }
+        path.pop_back();
+    }
+
+    template <typename Visit>
+    void visitAll(Visit visit) const {
+        vector<int> path;
+        for (const auto& root : roots) {
+            visitSubtree(root.second, path, visit);
+        }
+    }
+
+public:
+    // Inserts the simplex together with all its faces
+    void insert(vector<int> simplex) {
+        sort(simplex.begin(), simplex.end());
+        insertFaces(NONE, simplex, 0);
+    }
+
+    // Index of the node of a sorted simplex, NONE if it is not in the complex
+    int find(const vector<int>& sortedSimplex) const {
+        int node = NONE;
+        for (int v : sortedSimplex) {
+            node = child(node, v);
+            if (node == NONE) return NONE;
+        }
+        return node;
+    }
+
+    bool contains(vector<int> simplex) const {
+        sort(simplex.begin(), simplex.end());
+        return not simplex.empty() and find(simplex) != NONE;
+    }
+
+    size_t size() const {
+        return nodes.size();
     }
+
+    const vector<long long>& countsByDimension() const {
+        return countByDim;
+    }
+
+    // Visits all simplices in lexicographic order
+    template <typename Visit>
+    void forEachSimplex(Visit visit) const {
+        visitAll([&](int, const vector<int>& simplex) { visit(simplex); });
+    }
+
+    // Visits the codimension-1 faces of a simplex
+    template <typename Visit>
+    void forEachBoundaryFace(vector<int> simplex, Visit visit) const {
+        sort(simplex.begin(), simplex.end());
+        if (simplex.size() <= 1) return;
+        vector<int> face;
+        for (size_t omit = 0; omit < simplex.size(); omit++) {
+            face.clear();
+            for (size_t i = 0; i < simplex.size(); i++) {
+                if (i != omit) face.push_back(simplex[i]);
+            }
+            visit(face);
+        }
+    }
+
+    // Visits the proper cofaces of a simplex. Every coface passes through a node of the last vertex
+    // whose root path contains the simplex, so it is enough to walk those subtrees.
+    template <typename Visit>
+    void forEachCoface(vector<int> simplex, Visit visit) const {
+        sort(simplex.begin(), simplex.end());
+        if (simplex.empty()) return;
+        auto last = lastWithVertex.find(simplex.back());
+        if (last == lastWithVertex.end()) return;
+        int minDimension = (int)simplex.size() - 1;
+        vector<int> path;
+        for (int node = last->second; node != NONE; node = nodes[node].nextSameVertex) {
+            if (nodes[node].dimension < minDimension or not pathContains(node, simplex)) continue;
+            verticesOf(nodes[node].parent, path);
+            auto properCoface = [&](int, const vector<int>& coface) {
+                if (coface.size() > simplex.size()) visit(coface);
+            };
+            visitSubtree(node, path, properCoface);
+        }
+    }
+
+    // Simplices that are a face of exactly one simplex of the complex, in lexicographic order
+    vector<vector<int>> boundaryFaces() const {
+        vector<uint32_t> cofacets(nodes.size(), 0);
+        vector<int> vertices, face;
+        for (int node = 0; node < (int)nodes.size(); node++) {
+            if (nodes[node].dimension == 0) continue;
+            cofacets[nodes[node].parent]++;
+            verticesOf(node, vertices);
+            for (size_t omit = 0; omit + 1 < vertices.size(); omit++) {
+                face.clear();
+                for (size_t i = 0; i < vertices.size(); i++) {
+                    if (i != omit) face.push_back(vertices[i]);
+                }
+                cofacets[find(face)]++;
+            }
+        }
+        vector<vector<int>> res;
+        visitAll([&](int node, const vector<int>& simplex) {
+            if (cofacets[node] == 1) res.push_back(simplex);
+        });
+        return res;
+    }
+
+    // Sparse Z2 boundary matrices. matrices[d] has one column per d-simplex in lexicographic order,
+    // listing the sorted row indices of its facets among the (d-1)-simplices.
+    vector<vector<vector<int>>> boundaryMatrices() const {
+        vector<int> index(nodes.size());
+        vector<int> order;
+        vector<int> counter(countByDim.size(), 0);
+        visitAll([&](int node, const vector<int>&) {
+            index[node] = counter[nodes[node].dimension]++;
+            order.push_back(node);
+        });
+        vector<vector<vector<int>>> matrices(countByDim.size());
+        for (size_t d = 1; d < matrices.size(); d++) {
+            matrices[d].reserve(countByDim[d]);
+        }
+        vector<int> vertices, face;
+        for (int node : order) {
+            if (nodes[node].dimension == 0) continue;
+            verticesOf(node, vertices);
+            vector<int> column = { index[nodes[node].parent] };
+            for (size_t omit = 0; omit + 1 < vertices.size(); omit++) {
+                face.clear();
+                for (size_t i = 0; i < vertices.size(); i++) {
+                    if (i != omit) face.push_back(vertices[i]);
+                }
+                column.push_back(index[find(face)]);
+            }
+            sort(column.begin(), column.end());
+            matrices[nodes[node].dimension].push_back(column);
+        }
+        return matrices;
+    }
+};
+
+// General path for simplices with more than 4 vertices
+ComplexSummary summarizeTree(const vector<vector<int>>& inputSimplices) {
+    SimplexTree tree;
+    for (const auto& s : inputSimplices) {
+        tree.insert(s);
+    }
+    return { tree.countsByDimension(), tree.boundaryFaces() };
+}
+
+void printCounts(const vector<long long>& countByDim) {
     long long chi = 0;
     for (size_t d = 0; d < countByDim.size(); ++d) {
         if (d % 2 == 0) chi += countByDim[d];
@@ -122,22 +686,407 @@ void findBoundary(const string& filename) {
         cout << label << ": " << countByDim[d] << '\n';
     }
     cout << "chi: " << chi << "\n\n";
-    if (boundaryFaces.empty()) cout << "Boundary:\nis empty\n";
+}
+
+void printFace(const int* vertices, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        if (i) cout << ' ';
+        cout << vertices[i];
+    }
+    cout << '\n';
+}
+
+void printSummary(const ComplexSummary& summary) {
+    printCounts(summary.countByDim);
+    if (summary.boundaryFaces.empty()) cout << "Boundary:\nis empty\n";
     else {
-        for (const auto &f : boundaryFaces) {
-            for (size_t i = 0; i < f.size(); ++i) {
-                if (i) cout << ' ';
-                cout << f[i];
+        for (const auto &f : summary.boundaryFaces) {
+            printFace(f.data(), f.size());
+        }
+    }
+}
+
+// Adds column source to target over Z2 (symmetric difference of sorted row lists)
+void addColumn(vector<int>& target, const vector<int>& source, vector<int>& buffer) {
+    buffer.clear();
+    set_symmetric_difference(target.begin(), target.end(), source.begin(), source.end(), back_inserter(buffer));
+    target.swap(buffer);
+}
+
+// Column reduction of one boundary matrix, the pivot is the lowest one (largest row index).
+// Cleared columns are known to reduce to zero and are skipped. Returns the rank and marks
+// the pivot rows, those are the columns cleared in the matrix one dimension lower.
+long long reduceBoundaryMatrix(vector<vector<int>>& columns, size_t rowCount, const vector<char>& cleared, vector<char>& pivotRows) {
+    vector<int> pivotOwner(rowCount, -1);
+    pivotRows.assign(rowCount, 0);
+    vector<int> buffer;
+    long long rank = 0;
+    for (size_t j = 0; j < columns.size(); j++) {
+        vector<int>& column = columns[j];
+        if (not cleared.empty() and cleared[j]) {
+            vector<int>().swap(column);
+            continue;
+        }
+        while (not column.empty() and pivotOwner[column.back()] != -1) {
+            addColumn(column, columns[pivotOwner[column.back()]], buffer);
+        }
+        if (not column.empty()) {
+            pivotOwner[column.back()] = (int)j;
+            pivotRows[column.back()] = 1;
+            rank++;
+        }
+    }
+    return rank;
+}
+
+int findRoot(vector<int>& parent, int x) {
+    while (parent[x] != x) {
+        parent[x] = parent[parent[x]];
+        x = parent[x];
+    }
+    return x;
+}
+
+// Betti numbers over Z2, b_d = n_d - rank(boundary_d) - rank(boundary_d+1).
+// Dimension 1 is reduced with union-find, the edges joining two components are the nonzero
+// (negative) columns and their rows are dropped from the triangle columns (compression).
+// Higher dimensions are reduced top-down, pivots of dimension d+1 clear columns of dimension d (twist).
+vector<long long> bettiNumbers(const SimplexTree& tree) {
+    vector<long long> counts = tree.countsByDimension();
+    size_t dims = counts.size();
+    vector<vector<vector<int>>> matrices = tree.boundaryMatrices();
+    vector<long long> rank(dims + 1, 0);
+
+    vector<char> negativeEdges;
+    if (dims > 1) {
+        vector<int> parent(counts[0]);
+        for (size_t v = 0; v < parent.size(); v++) parent[v] = (int)v;
+        negativeEdges.assign(matrices[1].size(), 0);
+        for (size_t j = 0; j < matrices[1].size(); j++) {
+            const vector<int>& edge = matrices[1][j];
+            int a = findRoot(parent, edge[0]);
+            int b = findRoot(parent, edge[1]);
+            if (a == b) continue;
+            parent[a] = b;
+            negativeEdges[j] = 1;
+            rank[1]++;
+        }
+    }
+
+    vector<char> cleared, pivotRows;
+    for (size_t d = dims; d-- > 2;) {
+        if (d == 2) {
+            for (auto& column : matrices[2]) {
+                column.erase(remove_if(column.begin(), column.end(), [&](int row) { return negativeEdges[row] != 0; }), column.end());
             }
-            cout << '\n';
         }
+        rank[d] = reduceBoundaryMatrix(matrices[d], (size_t)counts[d - 1], cleared, pivotRows);
+        cleared.swap(pivotRows);
+        vector<vector<int>>().swap(matrices[d]);
+    }
+
+    vector<long long> betti(dims);
+    for (size_t d = 0; d < dims; d++) {
+        betti[d] = counts[d] - rank[d] - rank[d + 1];
+    }
+    return betti;
+}
+
+void printBettiNumbers(const vector<long long>& betti) {
+    cout << "\nBetti numbers:\n";
+    for (size_t d = 0; d < betti.size(); d++) {
+        cout << "b" << d << ": " << betti[d] << '\n';
+    }
+}
+
+// Sorts fixed-width simplex records (vertex count, then the vertices) within a memory budget.
+// Full buffers are sorted and spilled to temporary files, the runs are then merged, at most
+// MAX_FAN_IN at a time so the number of open files stays bounded.
+class ExternalSimplexSorter {
+private:
+    static constexpr size_t MAX_FAN_IN = 128;
+
+    size_t width;
+    size_t capacity;
+    vector<int> buffer;
+    vector<FILE*> runs;
+
+    static bool lessRecord(const int* a, const int* b) {
+        int n = min(a[0], b[0]);
+        for (int i = 1; i <= n; i++) {
+            if (a[i] != b[i]) return a[i] < b[i];
+        }
+        return a[0] < b[0];
+    }
+
+    FILE* newRun() {
+        FILE* run = tmpfile();
+        if (run == nullptr) {
+            throw runtime_error("Unable to create spill file");
+        }
+        return run;
+    }
+
+    template <typename Visit>
+    void visitBuffer(Visit& visit) {
+        size_t count = buffer.size() / width;
+        vector<uint32_t> order(count);
+        for (size_t i = 0; i < count; i++) order[i] = (uint32_t)i;
+        sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+            return lessRecord(&buffer[a * width], &buffer[b * width]);
+        });
+        for (uint32_t i : order) {
+            visit(&buffer[i * width]);
+        }
+        buffer.clear();
+    }
+
+    void spill() {
+        FILE* run = newRun();
+        auto write = [&](const int* record) {
+            if (fwrite(record, sizeof(int), width, run) != width) {
+                throw runtime_error("Unable to write spill file");
+            }
+        };
+        visitBuffer(write);
+        rewind(run);
+        runs.push_back(run);
+    }
+
+    // k-way merge of runs[first, last), the files are closed afterwards
+    template <typename Visit>
+    void mergeRuns(size_t first, size_t last, Visit& visit) {
+        size_t k = last - first;
+        vector<int> heads(k * width);
+        auto readHead = [&](size_t i) {
+            return fread(&heads[i * width], sizeof(int), width, runs[first + i]) == width;
+        };
+        auto greaterHead = [&](size_t a, size_t b) {
+            return lessRecord(&heads[b * width], &heads[a * width]);
+        };
+        priority_queue<size_t, vector<size_t>, decltype(greaterHead)> queue(greaterHead);
+        for (size_t i = 0; i < k; i++) {
+            if (readHead(i)) queue.push(i);
+        }
+        while (not queue.empty()) {
+            size_t i = queue.top();
+            queue.pop();
+            visit(&heads[i * width]);
+            if (readHead(i)) queue.push(i);
+        }
+        for (size_t i = first; i < last; i++) {
+            fclose(runs[i]);
+        }
+    }
+
+public:
+    ExternalSimplexSorter(int maxVertices, size_t memoryBudget) : width(maxVertices + 1) {
+        capacity = max<size_t>(1, memoryBudget / ((width + 1) * sizeof(int)));
+        buffer.reserve(min<size_t>(capacity, 1 << 16) * width);
+    }
+
+    ~ExternalSimplexSorter() {
+        for (FILE* run : runs) {
+            if (run != nullptr) fclose(run);
+        }
+    }
+
+    ExternalSimplexSorter(const ExternalSimplexSorter&) = delete;
+    ExternalSimplexSorter& operator=(const ExternalSimplexSorter&) = delete;
+
+    void add(const int* vertices, int n) {
+        buffer.push_back(n);
+        buffer.insert(buffer.end(), vertices, vertices + n);
+        buffer.resize(buffer.size() + (width - 1 - n), 0);
+        if (buffer.size() / width >= capacity) spill();
+    }
+
+    // Visits all records in lexicographic order of the vertex lists, duplicates included.
+    // visit gets the vertex count followed by the vertices.
+    template <typename Visit>
+    void merge(Visit visit) {
+        if (runs.empty()) {
+            visitBuffer(visit);
+            return;
+        }
+        if (not buffer.empty()) spill();
+        vector<int>().swap(buffer);
+        while (runs.size() > MAX_FAN_IN) {
+            FILE* merged = newRun();
+            auto write = [&](const int* record) {
+                if (fwrite(record, sizeof(int), width, merged) != width) {
+                    throw runtime_error("Unable to write spill file");
+                }
+            };
+            mergeRuns(0, MAX_FAN_IN, write);
+            rewind(merged);
+            runs.erase(runs.begin(), runs.begin() + MAX_FAN_IN);
+            runs.push_back(merged);
+        }
+        mergeRuns(0, runs.size(), visit);
+        runs.clear();
+    }
+};
+
+// Out-of-core variant of findBoundary for complexes larger than memory. The closure of the input is
+// sorted externally and deduplicated in the merge, which counts the simplices and emits their
+// (n-1)-faces into a second sorter, its merge then prints the faces that occur exactly once.
+// Both sorters share the memory budget.
+void findBoundaryStreaming(const string& filename, size_t memoryBudget) {
+    int maxVertices = 0;
+    bool opened = forEachSimplexInFile(filename, [&](const vector<int>& s) {
+        maxVertices = max(maxVertices, (int)s.size());
+    });
+    if (not opened) return;
+    if (maxVertices == 0) {
+        cerr << "No simplices found in file.\n";
+        return;
+    }
+    if (maxVertices > 31) {
+        cerr << "Simplices with more than 31 vertices are not supported in streaming mode.\n";
+        return;
+    }
+    try {
+        ExternalSimplexSorter closure(maxVertices, memoryBudget / 2);
+        forEachSimplexInFile(filename, [&](vector<int> s) {
+            sort(s.begin(), s.end());
+            int n = (int)s.size();
+            int subset[32];
+            for (uint32_t mask = 1; mask < (1u << n); mask++) {
+                int k = 0;
+                for (int i = 0; i < n; i++) {
+                    if (mask & (1u << i)) subset[k++] = s[i];
+                }
+                closure.add(subset, k);
+            }
+        });
+
+        ExternalSimplexSorter faces(max(1, maxVertices - 1), memoryBudget / 2);
+        vector<long long> countByDim;
+        vector<int> previous;
+        closure.merge([&](const int* record) {
+            int n = record[0];
+            const int* v = record + 1;
+            if ((int)previous.size() == n and equal(v, v + n, previous.begin())) return;
+            previous.assign(v, v + n);
+            if ((int)countByDim.size() < n) countByDim.resize(n, 0);
+            countByDim[n - 1]++;
+            if (n <= 1) return;
+            int face[32];
+            for (int omit = 0; omit < n; omit++) {
+                int k = 0;
+                for (int i = 0; i < n; i++) {
+                    if (i != omit) face[k++] = v[i];
+                }
+                faces.add(face, k);
+            }
+        });
+        printCounts(countByDim);
+
+        vector<int> current;
+        long long occurrences = 0, boundarySize = 0;
+        auto flush = [&]() {
+            if (occurrences == 1) {
+                printFace(current.data(), current.size());
+                boundarySize++;
+            }
+        };
+        faces.merge([&](const int* record) {
+            int n = record[0];
+            const int* v = record + 1;
+            if ((int)current.size() == n and equal(v, v + n, current.begin())) {
+                occurrences++;
+                return;
+            }
+            flush();
+            current.assign(v, v + n);
+            occurrences = 1;
+        });
+        flush();
+        if (boundarySize == 0) cout << "Boundary:\nis empty\n";
+    } catch (const runtime_error& e) {
+        cerr << e.what() << '\n';
+    }
+}
+
+void test_betti() {
+    struct Case {
+        string name;
+        vector<vector<int>> simplices;
+        vector<long long> betti;
+    };
+    vector<vector<int>> torus;
+    for (int i = 0; i < 7; i++) {
+        torus.push_back({ i, (i + 1) % 7, (i + 3) % 7 });
+        torus.push_back({ i, (i + 2) % 7, (i + 3) % 7 });
+    }
+    vector<Case> cases = {
+        { "empty", {}, {} },
+        { "tetrahedron", { { 1, 2, 3, 4 } }, { 1, 0, 0, 0 } },
+        { "sphere", { { 1, 2, 3 }, { 1, 2, 4 }, { 1, 3, 4 }, { 2, 3, 4 } }, { 1, 0, 1 } },
+        { "circle + point", { { 1, 2 }, { 2, 3 }, { 1, 3 }, { 7 } }, { 2, 1 } },
+        { "torus", torus, { 1, 2, 1 } },
+        // 6-vertex projective plane, over Z2 every Betti number is 1
+        { "RP2", { { 1, 2, 3 }, { 1, 3, 4 }, { 1, 4, 5 }, { 1, 5, 6 }, { 1, 6, 2 },
+                   { 2, 3, 5 }, { 3, 4, 6 }, { 4, 5, 2 }, { 5, 6, 3 }, { 6, 2, 4 } }, { 1, 1, 1 } },
+    };
+    for (const auto& c : cases) {
+        SimplexTree tree;
+        for (const auto& s : c.simplices) {
+            tree.insert(s);
+        }
+        vector<long long> betti = bettiNumbers(tree);
+        cout << c.name << ":";
+        for (long long b : betti) {
+            cout << " " << b;
+        }
+        if (betti != c.betti) {
+            cout << " je to zle\n";
+            return;
+        }
+        cout << "\n";
+    }
+    cout << ":)\n";
+}
+
+const size_t PARALLEL_MIN_SIMPLICES = 10000;
+
+void findBoundary(const string& filename, bool withBetti = false) {
+    vector<vector<int>> inputSimplices = readSimplicesFromFile(filename);
+    if (inputSimplices.empty()) {
+        cerr << "No simplices found in file.\n";
+        return;
+    }
+    int threadCount = inputSimplices.size() < PARALLEL_MIN_SIMPLICES ? 1 : (int)max(1u, thread::hardware_concurrency());
+    ComplexSummary summary;
+    if (not summarizePacked(inputSimplices, summary, threadCount)) {
+        summary = summarizeTree(inputSimplices);
+    }
+    if (summary.countByDim.empty()) {
+        cout << "No simplices provided.\n";
+        return;
+    }
+    printSummary(summary);
+    if (withBetti) {
+        SimplexTree tree;
+        for (const auto& s : inputSimplices) {
+            tree.insert(s);
+        }
+        printBettiNumbers(bettiNumbers(tree));
     }
 }
 int main(int argc, char* argv[]) {
-    if (argc != 2) {
+    //test_betti();
+    if (argc == 4 and string(argv[2]) == "--stream") {
+        // memory budget in MB
+        findBoundaryStreaming(argv[1], (size_t)max(1, atoi(argv[3])) << 20);
+        return 0;
+    }
+    bool withBetti = argc == 3 and string(argv[2]) == "--betti";
+    if (argc != 2 and not withBetti) {
         cerr << "Not enough arguments\n";
         return 1;
     }
-    findBoundary(argv[1]);
+    findBoundary(argv[1], withBetti);
     return 0;
 }
\ No newline at end of file
@@ -2,7 +2,14 @@
 #include <vector>
 #include <algorithm>
 #include <string>
-#include <unordered_map>
+#include <array>
+#include <cstring>
+#include <cstdint>
+#include <random>
+#include <chrono>
+#ifdef __AVX2__
+#include <immintrin.h>
+#endif
 
 using std::vector, std::string;
 
@@ -55,33 +62,97 @@ void test() {
 	return;
 }
 
-int horspoolSearch(const string& text, const string& pattern) {
-	int m = pattern.size();
-	int i = m - 1;
-	
-	const int TABLESIZE = 255;
-	std::unordered_map<char, int> shifts;
-	for (unsigned char c = 0; c < TABLESIZE; c++) {
-		shifts[c] = m;
-	}
+typedef std::array<int, 256> ShiftTable;
 
+ShiftTable buildShiftTable(const string& pattern) {
+	int m = pattern.size();
+	ShiftTable shifts;
+	shifts.fill(m);
 	for (int i = 0; i < m - 1; i++) {
-		shifts[pattern[i]] = m - 1 - i;
+		shifts[(unsigned char)pattern[i]] = m - 1 - i;
 	}
+	return shifts;
+}
 
+// Visits the start of every occurrence (overlapping ones included), stops when visit returns false
+template <typename Visit>
+void horspoolScan(const string& text, const string& pattern, const ShiftTable& shifts, Visit visit) {
+	size_t m = pattern.size();
+	if (m == 0 || text.size() < m) {
+		return;
+	}
+	size_t i = m - 1;
 	while (i < text.size()) {
-		int k = 0;
+		size_t k = 0;
 		while (k <= m - 1 && pattern[m - 1 - k] == text[i - k]) {
 			k++;
 		}
-		if (k == m) {
-			return i - m + 1;
+		if (k == m && !visit(i - m + 1)) {
+			return;
+		}
+		i += shifts[(unsigned char)text[i]];
+	}
+}
+
+int horspoolSearch(const string& text, const string& pattern) {
+	int position = -1;
+	horspoolScan(text, pattern, buildShiftTable(pattern), [&](size_t found) {
+		position = found;
+		return false;
+	});
+	return position;
+}
+
+#ifdef __AVX2__
+// Candidate prefilter: the first and last byte of the pattern are compared against 32 text
+// positions at once, only positions where both match are verified with memcmp
+void avx2SearchAll(const string& text, const string& pattern, vector<size_t>& positions) {
+	size_t n = text.size();
+	size_t m = pattern.size();
+	const char* s = text.data();
+	const __m256i first = _mm256_set1_epi8(pattern[0]);
+	const __m256i last = _mm256_set1_epi8(pattern[m - 1]);
+	size_t i = 0;
+	for (; i + m - 1 + 32 <= n; i += 32) {
+		__m256i blockFirst = _mm256_loadu_si256((const __m256i*)(s + i));
+		__m256i blockLast = _mm256_loadu_si256((const __m256i*)(s + i + m - 1));
+		__m256i both = _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(last, blockLast));
+		uint32_t mask = _mm256_movemask_epi8(both);
+		while (mask != 0) {
+			size_t candidate = i + __builtin_ctz(mask);
+			if (m <= 2 || std::memcmp(s + candidate + 1, pattern.data() + 1, m - 2) == 0) {
+				positions.push_back(candidate);
+			}
+			mask &= mask - 1;
 		}
-		else {
-			i += shifts[text[i]];
+	}
+	for (; i + m <= n; i++) {
+		if (std::memcmp(s + i, pattern.data(), m) == 0) {
+			positions.push_back(i);
 		}
 	}
-	return -1;
+}
+#endif
+
+const size_t SIMD_MIN_TEXT = 256;
+
+// Starts of all occurrences in increasing order, overlapping ones included
+vector<size_t> horspoolSearchAll(const string& text, const string& pattern) {
+	vector<size_t> positions;
+	if (pattern.empty() || text.size() < pattern.size()) {
+		return positions;
+	}
+#ifdef __AVX2__
+	if (text.size() >= SIMD_MIN_TEXT) {
+		avx2SearchAll(text, pattern, positions);
+		return positions;
+	}
+#endif
+	horspoolScan(text, pattern, buildShiftTable(pattern), [&](size_t found) {
+		positions.push_back(found);
+		return true;
+	});
+	return positions;
 }
 
 void test2() {
@@ -93,8 +164,58 @@ void test2() {
 	return;
 }
 
+void testSearchAll() {
+	std::mt19937 rng(7);
+	for (int round = 0; round < 2000; round++) {
+		string text(rng() % 600, 'a');
+		for (auto& c : text) {
+			c = 'a' + rng() % 3;
+		}
+		string pattern(1 + rng() % 6, 'a');
+		for (auto& c : pattern) {
+			c = 'a' + rng() % 3;
+		}
+		vector<size_t> expected;
+		for (size_t p = text.find(pattern); p != string::npos; p = text.find(pattern, p + 1)) {
+			expected.push_back(p);
+		}
+		int first = expected.empty() ? -1 : (int)expected[0];
+		if (horspoolSearchAll(text, pattern) != expected || horspoolSearch(text, pattern) != first) {
+			std::cout << "je to zle\n";
+			return;
+		}
+	}
+	std::cout << ":)\n";
+}
+
+void benchmarkSearch(size_t textSize) {
+	std::mt19937 rng(42);
+	string text(textSize, ' ');
+	for (auto& c : text) {
+		c = 'a' + rng() % 26;
+	}
+	string pattern = "horspool";
+	text.replace(textSize / 2, pattern.size(), pattern);
+
+	auto report = [&](const char* name, auto search) {
+		auto start = std::chrono::steady_clock::now();
+		size_t found = search();
+		double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+		std::cout << name << ": " << textSize / seconds / 1e9 << " GB/s (" << found << " matches)\n";
+	};
+
+	report("horspoolScan     ", [&]() {
+		size_t found = 0;
+		horspoolScan(text, pattern, buildShiftTable(pattern), [&](size_t) { found++; return true; });
+		return found;
+	});
+	report("horspoolSearchAll", [&]() { return horspoolSearchAll(text, pattern).size(); });
+}
+
 int main() {
 	//test();
 	test2();
+	//testSearchAll();
+	//benchmarkSearch(1 << 28);
 	return 0;
 }
\ No newline at end of file